@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+namespace array_view {
+
+    // Непрерывный диапазон элементов, которым владеет кто-то другой (аналог std::span из C++20)
+    template <typename Value>
+    class ArrayView {
+    public:
+        ArrayView() = default;
+
+        ArrayView(const Value* data, size_t size)
+                : data_(data)
+                , size_(size) {}
+
+        const Value* begin() const {
+            return data_;
+        }
+
+        const Value* end() const {
+            return data_ + size_;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        const Value& operator[](size_t index) const {
+            return data_[index];
+        }
+
+    private:
+        const Value* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+}  // namespace array_view
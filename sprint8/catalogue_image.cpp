@@ -0,0 +1,354 @@
+#include "catalogue_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace catalogue_image {
+
+    using namespace std::literals;
+
+    // Раздел образа: массив из count элементов, начинающийся со смещения offset от начала образа
+    struct Section {
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    struct ImageHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        Section stops;              // StopRecord, индексируется StopId
+        Section stop_name_order;    // StopId по возрастанию имён
+        Section buses;              // BusRecord, индексируется BusId
+        Section bus_name_order;     // BusId по возрастанию имён
+        Section route_stops;        // StopId всех маршрутов подряд
+        Section stop_buses;         // BusId всех остановок подряд
+        Section distance_offsets;   // uint32_t, stop_count + 1 (CSR)
+        Section distance_targets;   // StopId
+        Section distance_values;    // int32_t
+        Section strings;            // char, пул имён
+        Section extra;              // char
+    };
+
+    struct StopRecord {
+        double lat;
+        double lng;
+        uint32_t name_offset;
+        uint32_t name_length;
+        uint32_t buses_offset;
+        uint32_t buses_count;
+    };
+
+    struct BusRecord {
+        BusStat stat;
+        uint32_t name_offset;
+        uint32_t name_length;
+        uint32_t stops_offset;
+        uint32_t stops_count;
+        uint32_t is_circular;
+        uint32_t reserved;
+    };
+
+    namespace {
+
+        constexpr char MAGIC[8] = { 'T', 'C', 'I', 'M', 'A', 'G', 'E', '\0' };
+        constexpr uint32_t FORMAT_VERSION = 1;
+        constexpr size_t SECTION_ALIGNMENT = 8;
+
+        static_assert(std::is_trivially_copyable_v<ImageHeader>);
+        static_assert(std::is_trivially_copyable_v<StopRecord>);
+        static_assert(std::is_trivially_copyable_v<BusRecord>);
+
+        [[noreturn]] void ThrowCorrupted(const char* what) {
+            throw std::runtime_error("Catalogue image is corrupted: "s + what);
+        }
+
+        // Дописывает массив в конец образа, выравнивая начало раздела
+        template <typename Value>
+        Section AppendSection(std::string& image, const Value* data, size_t count) {
+            static_assert(std::is_trivially_copyable_v<Value>);
+            image.resize((image.size() + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT, '\0');
+            const Section section{ image.size(), count };
+            image.append(reinterpret_cast<const char*>(data), count * sizeof(Value));
+            return section;
+        }
+
+        template <typename Value>
+        Section AppendSection(std::string& image, const std::vector<Value>& values) {
+            return AppendSection(image, values.data(), values.size());
+        }
+
+        uint32_t AddString(std::string& strings, std::string_view text) {
+            const auto offset = static_cast<uint32_t>(strings.size());
+            strings.append(text);
+            return offset;
+        }
+
+    }  // namespace
+
+    std::string BuildImage(const transport_catalogue::TransportCatalogue& tc, std::string_view extra) {
+        const auto& stops = tc.GetStops();
+        const auto& buses = tc.GetBuses();
+        std::string strings;
+
+        std::vector<BusRecord> bus_records;
+        std::vector<domain::StopId> route_stops;
+        bus_records.reserve(buses.size());
+        for (domain::BusId id = 0; id < buses.size(); ++id) {
+            const auto& bus = buses[id];
+            const auto& info = tc.GetBusInfo(id);
+            BusRecord record{};
+            record.stat = { info.len, info.curvature, static_cast<uint32_t>(info.count_stops),
+                            static_cast<uint32_t>(info.unique_count_stops) };
+            record.name_offset = AddString(strings, bus.name);
+            record.name_length = static_cast<uint32_t>(bus.name.size());
+            record.stops_offset = static_cast<uint32_t>(route_stops.size());
+            record.stops_count = static_cast<uint32_t>(bus.stops.size());
+            record.is_circular = bus.is_circular;
+            route_stops.insert(route_stops.end(), bus.stops.begin(), bus.stops.end());
+            bus_records.push_back(record);
+        }
+
+        const auto by_bus_name = [&buses](domain::BusId lhs, domain::BusId rhs) {
+            return buses[lhs].name < buses[rhs].name;
+        };
+
+        std::vector<StopRecord> stop_records;
+        std::vector<domain::BusId> stop_buses;
+        stop_records.reserve(stops.size());
+        for (domain::StopId id = 0; id < stops.size(); ++id) {
+            const auto& stop = stops[id];
+            const auto& bus_ids = tc.GetBusIdsByStop(id);
+            StopRecord record{};
+            record.lat = stop.coordinates.lat;
+            record.lng = stop.coordinates.lng;
+            record.name_offset = AddString(strings, stop.name);
+            record.name_length = static_cast<uint32_t>(stop.name.size());
+            record.buses_offset = static_cast<uint32_t>(stop_buses.size());
+            record.buses_count = static_cast<uint32_t>(bus_ids.size());
+            // Каталог уже хранит маршруты остановки по возрастанию имени
+            stop_buses.insert(stop_buses.end(), bus_ids.begin(), bus_ids.end());
+            stop_records.push_back(record);
+        }
+
+        std::vector<domain::StopId> stop_name_order(stops.size());
+        for (domain::StopId id = 0; id < stops.size(); ++id) {
+            stop_name_order[id] = id;
+        }
+        std::sort(stop_name_order.begin(), stop_name_order.end(), [&stops](domain::StopId lhs, domain::StopId rhs) {
+            return stops[lhs].name < stops[rhs].name;
+        });
+
+        std::vector<domain::BusId> bus_name_order(buses.size());
+        for (domain::BusId id = 0; id < buses.size(); ++id) {
+            bus_name_order[id] = id;
+        }
+        std::sort(bus_name_order.begin(), bus_name_order.end(), by_bus_name);
+
+        std::vector<uint32_t> distance_offsets(stops.size() + 1, 0);
+        std::vector<domain::StopId> distance_targets;
+        std::vector<int32_t> distance_values;
+        for (const auto& [from, to, distance] : tc.GetDistances()) {
+            ++distance_offsets[from + 1];
+            distance_targets.push_back(to);
+            distance_values.push_back(distance);
+        }
+        for (size_t i = 1; i < distance_offsets.size(); ++i) {
+            distance_offsets[i] += distance_offsets[i - 1];
+        }
+
+        ImageHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = FORMAT_VERSION;
+
+        std::string image(sizeof(header), '\0');
+        header.stops = AppendSection(image, stop_records);
+        header.stop_name_order = AppendSection(image, stop_name_order);
+        header.buses = AppendSection(image, bus_records);
+        header.bus_name_order = AppendSection(image, bus_name_order);
+        header.route_stops = AppendSection(image, route_stops);
+        header.stop_buses = AppendSection(image, stop_buses);
+        header.distance_offsets = AppendSection(image, distance_offsets);
+        header.distance_targets = AppendSection(image, distance_targets);
+        header.distance_values = AppendSection(image, distance_values);
+        header.strings = AppendSection(image, strings.data(), strings.size());
+        header.extra = AppendSection(image, extra.data(), extra.size());
+        std::memcpy(image.data(), &header, sizeof(header));
+        return image;
+    }
+
+    CatalogueImage::CatalogueImage(std::string_view data)
+            : data_(data) {
+        if (reinterpret_cast<uintptr_t>(data.data()) % SECTION_ALIGNMENT != 0) {
+            throw std::runtime_error("Catalogue image buffer is not aligned");
+        }
+        if (data.size() < sizeof(ImageHeader) || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error("Not a catalogue image");
+        }
+        header_ = reinterpret_cast<const ImageHeader*>(data.data());
+        if (header_->version != FORMAT_VERSION) {
+            throw std::runtime_error("Unsupported catalogue image version");
+        }
+
+        // Проверяются только границы разделов; записи проверяются при обращении к ним,
+        // поэтому открытие образа не читает его целиком
+        GetArray<StopRecord>(header_->stops.offset, header_->stops.count);
+        GetArray<domain::StopId>(header_->stop_name_order.offset, header_->stop_name_order.count);
+        GetArray<BusRecord>(header_->buses.offset, header_->buses.count);
+        GetArray<domain::BusId>(header_->bus_name_order.offset, header_->bus_name_order.count);
+        GetArray<domain::StopId>(header_->route_stops.offset, header_->route_stops.count);
+        GetArray<domain::BusId>(header_->stop_buses.offset, header_->stop_buses.count);
+        GetArray<uint32_t>(header_->distance_offsets.offset, header_->distance_offsets.count);
+        GetArray<domain::StopId>(header_->distance_targets.offset, header_->distance_targets.count);
+        GetArray<int32_t>(header_->distance_values.offset, header_->distance_values.count);
+        GetArray<char>(header_->strings.offset, header_->strings.count);
+        GetArray<char>(header_->extra.offset, header_->extra.count);
+        if (header_->stop_name_order.count != header_->stops.count
+            || header_->bus_name_order.count != header_->buses.count
+            || header_->distance_offsets.count != header_->stops.count + 1
+            || header_->distance_values.count != header_->distance_targets.count) {
+            ThrowCorrupted("section sizes do not match");
+        }
+    }
+
+    template <typename Value>
+    ArrayView<Value> CatalogueImage::GetArray(uint64_t offset, uint64_t count) const {
+        if (offset % alignof(Value) != 0 || offset > data_.size()
+            || count > (data_.size() - offset) / sizeof(Value)) {
+            ThrowCorrupted("section is out of bounds");
+        }
+        return { reinterpret_cast<const Value*>(data_.data() + offset), static_cast<size_t>(count) };
+    }
+
+    std::string_view CatalogueImage::GetString(uint32_t offset, uint32_t length) const {
+        const auto strings = GetArray<char>(header_->strings.offset, header_->strings.count);
+        if (offset > strings.size() || length > strings.size() - offset) {
+            ThrowCorrupted("string is out of bounds");
+        }
+        return { strings.begin() + offset, length };
+    }
+
+    const StopRecord& CatalogueImage::GetStopRecord(domain::StopId id) const {
+        if (id >= header_->stops.count) {
+            throw std::out_of_range("Stop id is out of range");
+        }
+        return GetArray<StopRecord>(header_->stops.offset, header_->stops.count)[id];
+    }
+
+    const BusRecord& CatalogueImage::GetBusRecord(domain::BusId id) const {
+        if (id >= header_->buses.count) {
+            throw std::out_of_range("Bus id is out of range");
+        }
+        return GetArray<BusRecord>(header_->buses.offset, header_->buses.count)[id];
+    }
+
+    size_t CatalogueImage::GetStopCount() const {
+        return header_->stops.count;
+    }
+
+    size_t CatalogueImage::GetBusCount() const {
+        return header_->buses.count;
+    }
+
+    std::optional<domain::StopId> CatalogueImage::FindStop(std::string_view name) const {
+        const auto order = GetArray<domain::StopId>(header_->stop_name_order.offset, header_->stop_name_order.count);
+        const auto it = std::lower_bound(order.begin(), order.end(), name, [this](domain::StopId id, std::string_view value) {
+            return GetStopName(id) < value;
+        });
+        if (it == order.end() || GetStopName(*it) != name) {
+            return std::nullopt;
+        }
+        return *it;
+    }
+
+    std::optional<domain::BusId> CatalogueImage::FindBus(std::string_view name) const {
+        const auto order = GetArray<domain::BusId>(header_->bus_name_order.offset, header_->bus_name_order.count);
+        const auto it = std::lower_bound(order.begin(), order.end(), name, [this](domain::BusId id, std::string_view value) {
+            return GetBusName(id) < value;
+        });
+        if (it == order.end() || GetBusName(*it) != name) {
+            return std::nullopt;
+        }
+        return *it;
+    }
+
+    std::string_view CatalogueImage::GetStopName(domain::StopId id) const {
+        const auto& record = GetStopRecord(id);
+        return GetString(record.name_offset, record.name_length);
+    }
+
+    geo::Coordinates CatalogueImage::GetStopCoordinates(domain::StopId id) const {
+        const auto& record = GetStopRecord(id);
+        return { record.lat, record.lng };
+    }
+
+    ArrayView<domain::BusId> CatalogueImage::GetStopBuses(domain::StopId id) const {
+        const auto& record = GetStopRecord(id);
+        const auto all = GetArray<domain::BusId>(header_->stop_buses.offset, header_->stop_buses.count);
+        if (record.buses_offset > all.size() || record.buses_count > all.size() - record.buses_offset) {
+            ThrowCorrupted("stop buses are out of bounds");
+        }
+        return { all.begin() + record.buses_offset, record.buses_count };
+    }
+
+    std::string_view CatalogueImage::GetBusName(domain::BusId id) const {
+        const auto& record = GetBusRecord(id);
+        return GetString(record.name_offset, record.name_length);
+    }
+
+    bool CatalogueImage::IsBusCircular(domain::BusId id) const {
+        return GetBusRecord(id).is_circular != 0;
+    }
+
+    ArrayView<domain::StopId> CatalogueImage::GetBusStops(domain::BusId id) const {
+        const auto& record = GetBusRecord(id);
+        const auto all = GetArray<domain::StopId>(header_->route_stops.offset, header_->route_stops.count);
+        if (record.stops_offset > all.size() || record.stops_count > all.size() - record.stops_offset) {
+            ThrowCorrupted("bus stops are out of bounds");
+        }
+        return { all.begin() + record.stops_offset, record.stops_count };
+    }
+
+    const BusStat& CatalogueImage::GetBusStat(domain::BusId id) const {
+        return GetBusRecord(id).stat;
+    }
+
+    ArrayView<uint32_t> CatalogueImage::GetDistanceOffsets() const {
+        return GetArray<uint32_t>(header_->distance_offsets.offset, header_->distance_offsets.count);
+    }
+
+    ArrayView<domain::StopId> CatalogueImage::GetDistanceTargets() const {
+        return GetArray<domain::StopId>(header_->distance_targets.offset, header_->distance_targets.count);
+    }
+
+    ArrayView<int32_t> CatalogueImage::GetDistanceValues() const {
+        return GetArray<int32_t>(header_->distance_values.offset, header_->distance_values.count);
+    }
+
+    int CatalogueImage::GetDistance(domain::StopId from, domain::StopId to) const {
+        if (from >= GetStopCount()) {
+            throw std::out_of_range("Stop id is out of range");
+        }
+        const auto offsets = GetDistanceOffsets();
+        const auto targets = GetDistanceTargets();
+        if (offsets[from] > offsets[from + 1] || offsets[from + 1] > targets.size()) {
+            ThrowCorrupted("distance row is out of bounds");
+        }
+        const auto row_begin = targets.begin() + offsets[from];
+        const auto row_end = targets.begin() + offsets[from + 1];
+        const auto it = std::lower_bound(row_begin, row_end, to);
+        if (it != row_end && *it == to) {
+            return GetDistanceValues()[it - targets.begin()];
+        }
+        return 0;
+    }
+
+    std::string_view CatalogueImage::GetExtra() const {
+        const auto extra = GetArray<char>(header_->extra.offset, header_->extra.count);
+        return { extra.begin(), extra.size() };
+    }
+
+}  // namespace catalogue_image
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "array_view.h"
+#include "domain.h"
+#include "geo.h"
+#include "transport_catalogue.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace catalogue_image {
+
+    // Образ финализированного каталога, пригодный для чтения прямо из отображённого файла.
+    // Внутри только плоские массивы записей фиксированного размера, смещения и пул строк —
+    // ни одного указателя, поэтому образ не требует ни разбора, ни перемещения, а страницы
+    // одного файла могут разделять несколько процессов.
+    // Числа хранятся в порядке байтов машины, записавшей образ
+
+    using array_view::ArrayView;
+
+    // Статистика маршрута, посчитанная при записи образа
+    struct BusStat {
+        double route_length;
+        double curvature;
+        uint32_t stop_count;
+        uint32_t unique_stop_count;
+    };
+
+    struct ImageHeader;
+    struct StopRecord;
+    struct BusRecord;
+
+    // Строит образ каталога; к нему дописывается произвольный блок extra (например, настройки)
+    std::string BuildImage(const transport_catalogue::TransportCatalogue& tc, std::string_view extra);
+
+    // Представление образа, лежащего в памяти. Сами данные не копируются: буфер должен жить
+    // дольше представления и начинаться с адреса, выровненного на 8 байт (как у mmap и new).
+    // Конструктор проверяет заголовок и границы всех разделов и бросает std::runtime_error
+    class CatalogueImage {
+    public:
+        explicit CatalogueImage(std::string_view data);
+
+        size_t GetStopCount() const;
+        size_t GetBusCount() const;
+
+        // Поиск по имени — двоичный поиск по отсортированному списку имён
+        std::optional<domain::StopId> FindStop(std::string_view name) const;
+        std::optional<domain::BusId> FindBus(std::string_view name) const;
+
+        std::string_view GetStopName(domain::StopId id) const;
+        geo::Coordinates GetStopCoordinates(domain::StopId id) const;
+        // Маршруты через остановку, отсортированные по имени
+        ArrayView<domain::BusId> GetStopBuses(domain::StopId id) const;
+
+        std::string_view GetBusName(domain::BusId id) const;
+        bool IsBusCircular(domain::BusId id) const;
+        ArrayView<domain::StopId> GetBusStops(domain::BusId id) const;
+        const BusStat& GetBusStat(domain::BusId id) const;
+
+        // Все расстояния, включая достроенные обратные, по возрастанию (from, to)
+        ArrayView<uint32_t> GetDistanceOffsets() const;
+        ArrayView<domain::StopId> GetDistanceTargets() const;
+        ArrayView<int32_t> GetDistanceValues() const;
+        int GetDistance(domain::StopId from, domain::StopId to) const;
+
+        std::string_view GetExtra() const;
+
+    private:
+        template <typename Value>
+        ArrayView<Value> GetArray(uint64_t offset, uint64_t count) const;
+        std::string_view GetString(uint32_t offset, uint32_t length) const;
+
+        const StopRecord& GetStopRecord(domain::StopId id) const;
+        const BusRecord& GetBusRecord(domain::BusId id) const;
+
+        std::string_view data_;
+        const ImageHeader* header_ = nullptr;
+    };
+
+}  // namespace catalogue_image
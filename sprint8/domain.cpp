@@ -2,8 +2,7 @@
 
 namespace domain {
     BusInfo::BusInfo()
-            : name("")
-            , count_stops(0)
+            : count_stops(0)
             , unique_count_stops(0)
             , len(0.0)
             , curvature(0.0)
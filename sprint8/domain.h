@@ -1,25 +1,36 @@
 #pragma once
 
-#include <string>
+#include <cstdint>
 #include <vector>
 #include <string_view>
 #include "geo.h"
 
 namespace domain {
 
+    // Плотные идентификаторы, выдаваемые каталогом при загрузке
+    using StopId = uint32_t;
+    using BusId = uint32_t;
+
+    // Имена — представления: каталог хранит сами строки в общем пуле (см. name_pool.h)
     struct Stop {
-        std::string name;
+        std::string_view name;
         geo::Coordinates coordinates;
     };
 
     struct Bus {
-        std::string name;
-        std::vector<std::string_view> stops;
+        std::string_view name;
+        std::vector<StopId> stops;
         bool is_circular;
     };
 
+    // Расстояние по дорогам между соседними остановками, в метрах
+    struct RoadDistance {
+        StopId from;
+        StopId to;
+        int distance;
+    };
+
     struct BusInfo {
-        std::string name;
         size_t count_stops;
         size_t unique_count_stops;
         double len;
@@ -9,6 +9,17 @@ namespace geo {
         double lng;
     };
 
+    // Прямоугольник в географических координатах: min — юго-западный угол, max — северо-восточный
+    struct BoundingBox {
+        Coordinates min;
+        Coordinates max;
+
+        bool Contains(Coordinates point) const {
+            return point.lat >= min.lat && point.lat <= max.lat
+                   && point.lng >= min.lng && point.lng <= max.lng;
+        }
+    };
+
     double ComputeDistance(Coordinates from, Coordinates to);
 
     inline bool IsZero(double value) {
@@ -0,0 +1,175 @@
+#include "geo_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace geo {
+
+    namespace {
+
+        // Среднее число точек в ячейке, на которое рассчитан размер сетки
+        constexpr double POINTS_PER_CELL = 4;
+
+        // Должен совпадать с радиусом в ComputeDistance
+        constexpr double EARTH_RADIUS = 6371000;
+        constexpr double PI = 3.14159265358979323846;
+        constexpr double DEGREES_PER_RADIAN = 180.0 / PI;
+
+        // ComputeDistance для совпадающих точек может дать NaN из-за acos от числа чуть больше 1
+        double Distance(Coordinates from, Coordinates to) {
+            const double distance = ComputeDistance(from, to);
+            return std::isnan(distance) ? 0 : distance;
+        }
+
+        bool IsCloser(const GridIndex::Neighbor& lhs, const GridIndex::Neighbor& rhs) {
+            return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.index < rhs.index);
+        }
+
+        // Прямоугольник, заведомо содержащий круг радиуса radius метров с центром center
+        BoundingBox GetCircleBounds(Coordinates center, double radius) {
+            // Небольшой запас покрывает погрешность перевода метров в градусы
+            const double lat_delta = radius / EARTH_RADIUS * DEGREES_PER_RADIAN * 1.000001 + 1e-9;
+            const double far_lat = std::min(90.0, std::abs(center.lat) + lat_delta);
+            const double cos_lat = std::cos(far_lat / DEGREES_PER_RADIAN);
+            const double lng_delta = cos_lat > 1e-9 ? std::min(180.0, lat_delta / cos_lat) : 180.0;
+            if (lng_delta >= 180.0) {
+                return { { center.lat - lat_delta, -180.0 }, { center.lat + lat_delta, 180.0 } };
+            }
+            return { { center.lat - lat_delta, center.lng - lng_delta }, { center.lat + lat_delta, center.lng + lng_delta } };
+        }
+
+    }  // namespace
+
+    GridIndex::GridIndex(std::vector<Coordinates> points)
+            : points_(std::move(points)) {
+        if (points_.empty()) {
+            return;
+        }
+
+        bounds_ = { points_.front(), points_.front() };
+        for (const auto& point : points_) {
+            bounds_.min.lat = std::min(bounds_.min.lat, point.lat);
+            bounds_.min.lng = std::min(bounds_.min.lng, point.lng);
+            bounds_.max.lat = std::max(bounds_.max.lat, point.lat);
+            bounds_.max.lng = std::max(bounds_.max.lng, point.lng);
+        }
+
+        const auto side = static_cast<size_t>(std::ceil(std::sqrt(points_.size() / POINTS_PER_CELL)));
+        const double height = bounds_.max.lat - bounds_.min.lat;
+        const double width = bounds_.max.lng - bounds_.min.lng;
+        rows_ = height > 0 ? std::max<size_t>(side, 1) : 1;
+        columns_ = width > 0 ? std::max<size_t>(side, 1) : 1;
+        cell_height_ = height > 0 ? height / rows_ : 1;
+        cell_width_ = width > 0 ? width / columns_ : 1;
+
+        // Подсчёт точек по ячейкам, затем раскладка индексов; внутри ячейки индексы идут по возрастанию
+        std::vector<uint32_t> point_cells(points_.size());
+        cell_offsets_.assign(rows_ * columns_ + 1, 0);
+        for (size_t i = 0; i < points_.size(); ++i) {
+            point_cells[i] = static_cast<uint32_t>(GetRow(points_[i].lat) * columns_ + GetColumn(points_[i].lng));
+            ++cell_offsets_[point_cells[i] + 1];
+        }
+        for (size_t i = 1; i < cell_offsets_.size(); ++i) {
+            cell_offsets_[i] += cell_offsets_[i - 1];
+        }
+        std::vector<uint32_t> next(cell_offsets_.begin(), cell_offsets_.end() - 1);
+        cell_points_.resize(points_.size());
+        for (size_t i = 0; i < points_.size(); ++i) {
+            cell_points_[next[point_cells[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    size_t GridIndex::GetRow(double lat) const {
+        const double row = std::floor((lat - bounds_.min.lat) / cell_height_);
+        return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+    }
+
+    size_t GridIndex::GetColumn(double lng) const {
+        const double column = std::floor((lng - bounds_.min.lng) / cell_width_);
+        return static_cast<size_t>(std::clamp(column, 0.0, static_cast<double>(columns_ - 1)));
+    }
+
+    std::vector<uint32_t> GridIndex::FindInBox(const BoundingBox& box) const {
+        std::vector<uint32_t> result;
+        if (points_.empty() || box.max.lat < bounds_.min.lat || box.min.lat > bounds_.max.lat
+            || box.max.lng < bounds_.min.lng || box.min.lng > bounds_.max.lng) {
+            return result;
+        }
+
+        const size_t row_begin = GetRow(box.min.lat);
+        const size_t row_end = GetRow(box.max.lat) + 1;
+        const size_t column_begin = GetColumn(box.min.lng);
+        const size_t column_end = GetColumn(box.max.lng) + 1;
+        for (size_t row = row_begin; row < row_end; ++row) {
+            for (size_t column = column_begin; column < column_end; ++column) {
+                const size_t cell = row * columns_ + column;
+                for (uint32_t i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i) {
+                    const uint32_t point = cell_points_[i];
+                    if (box.Contains(points_[point])) {
+                        result.push_back(point);
+                    }
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<GridIndex::Neighbor> GridIndex::FindWithinRadius(Coordinates center, double radius) const {
+        std::vector<Neighbor> result;
+        if (radius < 0) {
+            return result;
+        }
+        for (const uint32_t index : FindInBox(GetCircleBounds(center, radius))) {
+            const double distance = Distance(center, points_[index]);
+            if (distance <= radius) {
+                result.push_back({ index, distance });
+            }
+        }
+        std::sort(result.begin(), result.end(), IsCloser);
+        return result;
+    }
+
+    void GridIndex::ScanCell(size_t row, size_t column, Coordinates center, std::optional<Neighbor>& best) const {
+        const size_t cell = row * columns_ + column;
+        for (uint32_t i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i) {
+            const Neighbor candidate{ cell_points_[i], Distance(center, points_[cell_points_[i]]) };
+            if (!best || IsCloser(candidate, *best)) {
+                best = candidate;
+            }
+        }
+    }
+
+    std::optional<GridIndex::Neighbor> GridIndex::FindNearest(Coordinates center) const {
+        if (points_.empty()) {
+            return std::nullopt;
+        }
+
+        // Кольцами ячеек вокруг центра ищется первая непустая окрестность. Найденная точка
+        // задаёт радиус, внутри которого лежит ближайшая; его и проверяем точным поиском
+        const auto center_row = static_cast<long>(GetRow(center.lat));
+        const auto center_column = static_cast<long>(GetColumn(center.lng));
+        const auto rows = static_cast<long>(rows_);
+        const auto columns = static_cast<long>(columns_);
+        std::optional<Neighbor> best;
+        for (long ring = 0; !best && ring < std::max(rows, columns); ++ring) {
+            for (long row = std::max(0L, center_row - ring); row <= std::min(rows - 1, center_row + ring); ++row) {
+                for (long column = std::max(0L, center_column - ring); column <= std::min(columns - 1, center_column + ring); ++column) {
+                    // Внутренние ячейки просмотрены на предыдущих кольцах
+                    if (std::max(std::abs(row - center_row), std::abs(column - center_column)) == ring) {
+                        ScanCell(row, column, center, best);
+                    }
+                }
+            }
+        }
+
+        const auto nearest = FindWithinRadius(center, best->distance);
+        return nearest.empty() ? best : nearest.front();
+    }
+
+    size_t GridIndex::GetMemoryUsage() const {
+        return points_.capacity() * sizeof(Coordinates)
+               + (cell_offsets_.capacity() + cell_points_.capacity()) * sizeof(uint32_t);
+    }
+
+}  // namespace geo
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "geo.h"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace geo {
+
+    // Равномерная сетка над набором точек. Точки лежат подряд по ячейкам (CSR),
+    // так что запрос просматривает только ячейки, задетые областью поиска.
+    // Точка определяется своим индексом во входном векторе
+    class GridIndex {
+    public:
+        struct Neighbor {
+            uint32_t index;
+            // Расстояние по ComputeDistance, в метрах
+            double distance;
+        };
+
+        GridIndex() = default;
+
+        explicit GridIndex(std::vector<Coordinates> points);
+
+        // Индексы точек внутри прямоугольника (границы включаются) по возрастанию
+        std::vector<uint32_t> FindInBox(const BoundingBox& box) const;
+
+        // Точки не дальше radius метров от center по возрастанию расстояния (при равенстве — индекса).
+        // Сетка отсекает кандидатов по описанному прямоугольнику, ComputeDistance уточняет
+        std::vector<Neighbor> FindWithinRadius(Coordinates center, double radius) const;
+
+        // Ближайшая к center точка; nullopt, если индекс пуст
+        std::optional<Neighbor> FindNearest(Coordinates center) const;
+
+        // Объём памяти под точки и ячейки, в байтах
+        size_t GetMemoryUsage() const;
+
+    private:
+        size_t GetRow(double lat) const;
+        size_t GetColumn(double lng) const;
+        void ScanCell(size_t row, size_t column, Coordinates center, std::optional<Neighbor>& best) const;
+
+        std::vector<Coordinates> points_;
+        BoundingBox bounds_ = { { 0, 0 }, { 0, 0 } };
+        size_t rows_ = 0;
+        size_t columns_ = 0;
+        double cell_height_ = 1;
+        double cell_width_ = 1;
+
+        // Точки ячейки (row, column) — cell_points_[cell_offsets_[c] .. cell_offsets_[c + 1]),
+        // где c = row * columns_ + column
+        std::vector<uint32_t> cell_offsets_;
+        std::vector<uint32_t> cell_points_;
+    };
+
+}  // namespace geo
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace graph {
+
+    using VertexId = uint32_t;
+    using EdgeId = uint32_t;
+
+    template <typename Weight>
+    struct Edge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+    };
+
+    // Ориентированный взвешенный граф. После заполнения исходящие рёбра вершин
+    // раскладываются подряд (CSR), чтобы обход соседей шёл по непрерывной памяти
+    template <typename Weight>
+    class DirectedWeightedGraph {
+    public:
+        DirectedWeightedGraph() = default;
+
+        explicit DirectedWeightedGraph(size_t vertex_count)
+                : vertex_count_(vertex_count) {}
+
+        EdgeId AddEdge(const Edge<Weight>& edge) {
+            edges_.push_back(edge);
+            incidence_built_ = false;
+            return static_cast<EdgeId>(edges_.size() - 1);
+        }
+
+        size_t GetVertexCount() const {
+            return vertex_count_;
+        }
+
+        size_t GetEdgeCount() const {
+            return edges_.size();
+        }
+
+        const Edge<Weight>& GetEdge(EdgeId edge_id) const {
+            return edges_.at(edge_id);
+        }
+
+        // Строит списки исходящих рёбер; вызывается после добавления всех рёбер
+        void BuildIncidence() {
+            incidence_offsets_.assign(vertex_count_ + 1, 0);
+            for (const auto& edge : edges_) {
+                ++incidence_offsets_[edge.from + 1];
+            }
+            for (size_t i = 1; i < incidence_offsets_.size(); ++i) {
+                incidence_offsets_[i] += incidence_offsets_[i - 1];
+            }
+            std::vector<uint32_t> next(incidence_offsets_.begin(), incidence_offsets_.end() - 1);
+            incident_edges_.resize(edges_.size());
+            for (EdgeId id = 0; id < edges_.size(); ++id) {
+                incident_edges_[next[edges_[id].from]++] = id;
+            }
+            incidence_built_ = true;
+        }
+
+        // Исходящие рёбра вершины — [begin, end) внутри массива идентификаторов рёбер
+        const EdgeId* IncidentEdgesBegin(VertexId vertex) const {
+            return incident_edges_.data() + incidence_offsets_[vertex];
+        }
+
+        const EdgeId* IncidentEdgesEnd(VertexId vertex) const {
+            return incident_edges_.data() + incidence_offsets_[vertex + 1];
+        }
+
+        bool IsIncidenceBuilt() const {
+            return incidence_built_;
+        }
+
+    private:
+        size_t vertex_count_ = 0;
+        std::vector<Edge<Weight>> edges_;
+        std::vector<uint32_t> incidence_offsets_;
+        std::vector<EdgeId> incident_edges_;
+        bool incidence_built_ = false;
+    };
+
+}  // namespace graph
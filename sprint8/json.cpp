@@ -1,14 +1,37 @@
 #include "json.h"
+#include "number_format.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <iterator>
+#include <streambuf>
 
 namespace json {
 
     namespace {
         using namespace std::literals;
 
-        Node LoadNode(std::istream& input);
-        Node LoadString(std::istream& input);
+        // Переводит текст числа, уже проверенный по грамматике JSON, без временных строк.
+        // Целое, не помещающееся в int, становится double, как и прежде
+        std::variant<int, double> ConvertNumber(std::string_view text, bool is_int) {
+            const char* const first = text.data();
+            const char* const last = text.data() + text.size();
+            if (is_int) {
+                int value = 0;
+                if (const auto [ptr, ec] = std::from_chars(first, last, value); ec == std::errc{} && ptr == last) {
+                    return value;
+                }
+            }
+            double value = 0;
+            if (const auto [ptr, ec] = std::from_chars(first, last, value); ec == std::errc{} && ptr == last) {
+                return value;
+            }
+            throw ParsingError("Failed to convert "s + std::string(text) + " to number"s);
+        }
+
+        Node LoadNode(std::istream& input, std::pmr::memory_resource* resource);
+        Node LoadString(std::istream& input, std::pmr::memory_resource* resource);
 
         std::string LoadLiteral(std::istream& input) {
             std::string s;
@@ -18,14 +41,14 @@ namespace json {
             return s;
         }
 
-        Node LoadArray(std::istream& input) {
-            std::vector<Node> result;
+        Node LoadArray(std::istream& input, std::pmr::memory_resource* resource) {
+            Array result(resource);
 
             for (char c; input >> c && c != ']';) {
                 if (c != ',') {
                     input.putback(c);
                 }
-                result.push_back(LoadNode(input));
+                result.push_back(LoadNode(input, resource));
             }
             if (!input) {
                 throw ParsingError("Array parsing error"s);
@@ -33,17 +56,17 @@ namespace json {
             return Node(std::move(result));
         }
 
-        Node LoadDict(std::istream& input) {
-            Dict dict;
+        Node LoadDict(std::istream& input, std::pmr::memory_resource* resource) {
+            Dict dict(resource);
 
             for (char c; input >> c && c != '}';) {
                 if (c == '"') {
-                    std::string key = LoadString(input).AsString();
+                    String key = std::get<String>(std::move(LoadString(input, resource).GetValue()));
                     if (input >> c && c == ':') {
                         if (dict.find(key) != dict.end()) {
-                            throw ParsingError("Duplicate key '"s + key + "' have been found");
+                            throw ParsingError("Duplicate key '"s + std::string(key) + "' have been found");
                         }
-                        dict.emplace(std::move(key), LoadNode(input));
+                        dict.emplace(std::move(key), LoadNode(input, resource));
                     }
                     else {
                         throw ParsingError(": is expected but '"s + c + "' has been found"s);
@@ -59,10 +82,10 @@ namespace json {
             return Node(std::move(dict));
         }
 
-        Node LoadString(std::istream& input) {
+        Node LoadString(std::istream& input, std::pmr::memory_resource* resource) {
             auto it = std::istreambuf_iterator<char>(input);
             auto end = std::istreambuf_iterator<char>();
-            std::string s;
+            String s(resource);
             while (true) {
                 if (it == end) {
                     throw ParsingError("String parsing error");
@@ -177,33 +200,23 @@ namespace json {
                 is_int = false;
             }
 
-            try {
-                if (is_int) {
-                    try {
-                        return std::stoi(parsed_num);
-                    }
-                    catch (...) {
-                    }
-                }
-                return std::stod(parsed_num);
-            }
-            catch (...) {
-                throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
-            }
+            return std::visit([](auto value) {
+                return Node(value);
+            }, ConvertNumber(parsed_num, is_int));
         }
 
-        Node LoadNode(std::istream& input) {
+        Node LoadNode(std::istream& input, std::pmr::memory_resource* resource) {
             char c;
             if (!(input >> c)) {
                 throw ParsingError("Unexpected EOF"s);
             }
             switch (c) {
                 case '[':
-                    return LoadArray(input);
+                    return LoadArray(input, resource);
                 case '{':
-                    return LoadDict(input);
+                    return LoadDict(input, resource);
                 case '"':
-                    return LoadString(input);
+                    return LoadString(input, resource);
                 case 't':
                     [[fallthrough]];
                 case 'f':
@@ -218,30 +231,465 @@ namespace json {
             }
         }
 
+        // Источник символов поверх std::streambuf: без sentry и проверки состояния потока на каждый символ
+        class StreamSource {
+        public:
+            static constexpr int END = std::char_traits<char>::eof();
+            static constexpr bool CONTIGUOUS = false;
+
+            explicit StreamSource(std::istream& input)
+                    : buf_(input.rdbuf()) {
+                if (!buf_) {
+                    throw ParsingError("Stream has no buffer"s);
+                }
+            }
+
+            int Peek() {
+                return buf_->sgetc();
+            }
+
+            int Get() {
+                return buf_->sbumpc();
+            }
+
+        private:
+            std::streambuf* buf_;
+        };
+
+        // Источник символов поверх непрерывного буфера (например, отображённого в память файла).
+        // Позволяет разбирать строки и числа без копирования
+        class BufferSource {
+        public:
+            static constexpr int END = std::char_traits<char>::eof();
+            static constexpr bool CONTIGUOUS = true;
+
+            explicit BufferSource(std::string_view input)
+                    : pos_(input.data())
+                    , end_(input.data() + input.size()) {
+            }
+
+            int Peek() const {
+                return pos_ == end_ ? END : static_cast<unsigned char>(*pos_);
+            }
+
+            int Get() {
+                return pos_ == end_ ? END : static_cast<unsigned char>(*pos_++);
+            }
+
+            const char* Position() const {
+                return pos_;
+            }
+
+            const char* End() const {
+                return end_;
+            }
+
+            void Advance(const char* pos) {
+                pos_ = pos;
+            }
+
+        private:
+            const char* pos_;
+            const char* end_;
+        };
+
+        template <typename Source>
+        class SaxParser {
+        public:
+            SaxParser(Source& source, Handler& handler)
+                    : source_(source)
+                    , handler_(handler) {
+            }
+
+            void ParseValue() {
+                switch (SkipSpaces()) {
+                    case Source::END:
+                        throw ParsingError("Unexpected EOF"s);
+                    case '[':
+                        source_.Get();
+                        ParseArray();
+                        break;
+                    case '{':
+                        source_.Get();
+                        ParseDict();
+                        break;
+                    case '"':
+                        source_.Get();
+                        handler_.OnString(ParseString());
+                        break;
+                    case 't':
+                        [[fallthrough]];
+                    case 'f':
+                        ParseBool();
+                        break;
+                    case 'n':
+                        ParseNull();
+                        break;
+                    default:
+                        ParseNumber();
+                        break;
+                }
+            }
+
+        private:
+            int SkipSpaces() {
+                int c = source_.Peek();
+                while (c != Source::END && std::isspace(c)) {
+                    source_.Get();
+                    c = source_.Peek();
+                }
+                return c;
+            }
+
+            void ParseArray() {
+                handler_.OnStartArray();
+                if (SkipSpaces() == ']') {
+                    source_.Get();
+                    handler_.OnEndArray();
+                    return;
+                }
+                while (true) {
+                    ParseValue();
+                    const int c = SkipSpaces();
+                    source_.Get();
+                    if (c == ']') {
+                        break;
+                    }
+                    if (c != ',') {
+                        throw ParsingError("Array parsing error"s);
+                    }
+                }
+                handler_.OnEndArray();
+            }
+
+            void ParseDict() {
+                handler_.OnStartDict();
+                if (SkipSpaces() == '}') {
+                    source_.Get();
+                    handler_.OnEndDict();
+                    return;
+                }
+                while (true) {
+                    if (SkipSpaces() != '"') {
+                        throw ParsingError("Dictionary parsing error"s);
+                    }
+                    source_.Get();
+                    handler_.OnKey(ParseString());
+                    if (SkipSpaces() != ':') {
+                        throw ParsingError("Dictionary parsing error"s);
+                    }
+                    source_.Get();
+                    ParseValue();
+                    const int c = SkipSpaces();
+                    source_.Get();
+                    if (c == '}') {
+                        break;
+                    }
+                    if (c != ',') {
+                        throw ParsingError("Dictionary parsing error"s);
+                    }
+                }
+                handler_.OnEndDict();
+            }
+
+            // Открывающая кавычка уже прочитана. Результат живёт до следующего разбора строки;
+            // для непрерывного буфера строка без escape-последовательностей возвращается как view в него
+            std::string_view ParseString() {
+                if constexpr (Source::CONTIGUOUS) {
+                    const char* const begin = source_.Position();
+                    const char* it = begin;
+                    for (const char* end = source_.End(); it != end; ++it) {
+                        if (*it == '"' || *it == '\\' || *it == '\n' || *it == '\r') {
+                            break;
+                        }
+                    }
+                    if (it != source_.End() && *it == '"') {
+                        source_.Advance(it + 1);
+                        return { begin, static_cast<size_t>(it - begin) };
+                    }
+                    buffer_.assign(begin, it);
+                    source_.Advance(it);
+                }
+                else {
+                    buffer_.clear();
+                }
+                while (true) {
+                    const int ch = source_.Get();
+                    if (ch == Source::END) {
+                        throw ParsingError("String parsing error"s);
+                    }
+                    if (ch == '"') {
+                        break;
+                    }
+                    if (ch == '\\') {
+                        const int escaped_char = source_.Get();
+                        switch (escaped_char) {
+                            case 'n':
+                                buffer_.push_back('\n');
+                                break;
+                            case 't':
+                                buffer_.push_back('\t');
+                                break;
+                            case 'r':
+                                buffer_.push_back('\r');
+                                break;
+                            case '"':
+                                buffer_.push_back('"');
+                                break;
+                            case '\\':
+                                buffer_.push_back('\\');
+                                break;
+                            case Source::END:
+                                throw ParsingError("String parsing error"s);
+                            default:
+                                throw ParsingError("Unrecognized escape sequence \\"s + static_cast<char>(escaped_char));
+                        }
+                    }
+                    else if (ch == '\n' || ch == '\r') {
+                        throw ParsingError("Unexpected end of line"s);
+                    }
+                    else {
+                        buffer_.push_back(static_cast<char>(ch));
+                    }
+                }
+                return buffer_;
+            }
+
+            std::string_view ParseLiteral() {
+                buffer_.clear();
+                for (int c = source_.Peek(); c != Source::END && std::isalpha(c); c = source_.Peek()) {
+                    buffer_.push_back(static_cast<char>(source_.Get()));
+                }
+                return buffer_;
+            }
+
+            void ParseBool() {
+                const auto s = ParseLiteral();
+                if (s == "true"sv) {
+                    handler_.OnBool(true);
+                }
+                else if (s == "false"sv) {
+                    handler_.OnBool(false);
+                }
+                else {
+                    throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
+                }
+            }
+
+            void ParseNull() {
+                if (const auto literal = ParseLiteral(); literal == "null"sv) {
+                    handler_.OnNull();
+                }
+                else {
+                    throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
+                }
+            }
+
+            void ParseNumber() {
+                buffer_.clear();
+                [[maybe_unused]] const char* begin = nullptr;
+                if constexpr (Source::CONTIGUOUS) {
+                    begin = source_.Position();
+                }
+
+                // Из непрерывного буфера текст числа берётся как есть, из потока копируется в buffer_
+                auto read_char = [this] {
+                    const int c = source_.Get();
+                    if constexpr (!Source::CONTIGUOUS) {
+                        buffer_.push_back(static_cast<char>(c));
+                    }
+                };
+
+                auto read_digits = [this, read_char] {
+                    if (!std::isdigit(source_.Peek())) {
+                        throw ParsingError("A digit is expected"s);
+                    }
+                    while (std::isdigit(source_.Peek())) {
+                        read_char();
+                    }
+                };
+
+                if (source_.Peek() == '-') {
+                    read_char();
+                }
+                if (source_.Peek() == '0') {
+                    read_char();
+                }
+                else {
+                    read_digits();
+                }
+
+                bool is_int = true;
+                if (source_.Peek() == '.') {
+                    read_char();
+                    read_digits();
+                    is_int = false;
+                }
+
+                if (int ch = source_.Peek(); ch == 'e' || ch == 'E') {
+                    read_char();
+                    if (ch = source_.Peek(); ch == '+' || ch == '-') {
+                        read_char();
+                    }
+                    read_digits();
+                    is_int = false;
+                }
+
+                std::string_view text = buffer_;
+                if constexpr (Source::CONTIGUOUS) {
+                    text = { begin, static_cast<size_t>(source_.Position() - begin) };
+                }
+                const auto value = ConvertNumber(text, is_int);
+                if (std::holds_alternative<int>(value)) {
+                    handler_.OnInt(std::get<int>(value));
+                }
+                else {
+                    handler_.OnDouble(std::get<double>(value));
+                }
+            }
+
+            Source& source_;
+            Handler& handler_;
+            std::string buffer_;
+        };
+
+        // Строит дерево Node из событий разбора, проверяя повторы ключей так же, как LoadDict
+        class DomBuilder final : public Handler {
+        public:
+            explicit DomBuilder(std::pmr::memory_resource* resource)
+                    : resource_(resource) {
+            }
+
+            void OnNull() override {
+                AddValue(Node{ nullptr });
+            }
+
+            void OnBool(bool value) override {
+                AddValue(Node{ value });
+            }
+
+            void OnInt(int value) override {
+                AddValue(Node{ value });
+            }
+
+            void OnDouble(double value) override {
+                AddValue(Node{ value });
+            }
+
+            void OnString(std::string_view value) override {
+                AddValue(Node{ String(value, resource_) });
+            }
+
+            void OnStartArray() override {
+                stack_.push_back({ Node{ Array(resource_) }, String(resource_) });
+            }
+
+            void OnEndArray() override {
+                CloseContainer();
+            }
+
+            void OnStartDict() override {
+                stack_.push_back({ Node{ Dict(resource_) }, String(resource_) });
+            }
+
+            void OnKey(std::string_view key) override {
+                const Dict& dict = std::get<Dict>(stack_.back().node.GetValue());
+                if (dict.find(key) != dict.end()) {
+                    throw ParsingError("Duplicate key '"s + std::string(key) + "' have been found");
+                }
+                stack_.back().key = String(key, resource_);
+            }
+
+            void OnEndDict() override {
+                CloseContainer();
+            }
+
+            Node Extract() {
+                return std::move(root_);
+            }
+
+        private:
+            struct Frame {
+                Node node;
+                String key;
+            };
+
+            void AddValue(Node value) {
+                if (stack_.empty()) {
+                    root_ = std::move(value);
+                    return;
+                }
+                Frame& frame = stack_.back();
+                if (auto* array = std::get_if<Array>(&frame.node.GetValue())) {
+                    array->push_back(std::move(value));
+                }
+                else {
+                    std::get<Dict>(frame.node.GetValue()).emplace(std::move(frame.key), std::move(value));
+                }
+            }
+
+            void CloseContainer() {
+                Node node = std::move(stack_.back().node);
+                stack_.pop_back();
+                AddValue(std::move(node));
+            }
+
+            std::pmr::memory_resource* resource_;
+            std::vector<Frame> stack_;
+            Node root_;
+        };
+
+        constexpr int INDENT_STEP = 4;
+
         struct PrintContext {
             std::ostream& out;
-            int indent_step = 4;
+            int indent_step = INDENT_STEP;
             int indent = 0;
+            bool compact = false;
 
             void PrintIndent() const {
-                for (int i = 0; i < indent; ++i) {
-                    out.put(' ');
+                if (compact) {
+                    return;
+                }
+                static constexpr std::string_view spaces = "                                "sv;
+                for (int left = indent; left > 0; left -= static_cast<int>(spaces.size())) {
+                    out.write(spaces.data(), std::min(left, static_cast<int>(spaces.size())));
+                }
+            }
+
+            // Перевод строки между элементами; в компактном формате не выводится
+            void PrintNewLine() const {
+                if (!compact) {
+                    out.put('\n');
                 }
             }
 
+            std::string_view KeySeparator() const {
+                return compact ? ":"sv : ": "sv;
+            }
+
             PrintContext Indented() const {
-                return { out, indent_step, indent_step + indent };
+                return { out, indent_step, indent_step + indent, compact };
             }
         };
 
+        // Контекст печати для значения на глубине depth внутри json::Writer
+        PrintContext WriterContext(std::ostream& out, bool compact, size_t depth) {
+            if (compact) {
+                return { out, 0, 0, true };
+            }
+            return { out, INDENT_STEP, INDENT_STEP * static_cast<int>(depth) };
+        }
+
         void PrintNode(const Node& value, const PrintContext& ctx);
 
+        // Числа: int и double
         template <typename Value>
         void PrintValue(const Value& value, const PrintContext& ctx) {
-            ctx.out << value;
+            ctx.out << number_format::Number{ value };
         }
 
-        void PrintString(const std::string& value, std::ostream& out) {
+        void PrintString(std::string_view value, std::ostream& out) {
             out.put('"');
             for (const char c : value) {
                 switch (c) {
@@ -268,7 +716,7 @@ namespace json {
         }
 
         template <>
-        void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
+        void PrintValue<String>(const String& value, const PrintContext& ctx) {
             PrintString(value, ctx.out);
         }
 
@@ -285,7 +733,8 @@ namespace json {
         template <>
         void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
             std::ostream& out = ctx.out;
-            out << "[\n"sv;
+            out.put('[');
+            ctx.PrintNewLine();
             bool first = true;
             auto inner_ctx = ctx.Indented();
             for (const Node& node : nodes) {
@@ -293,12 +742,13 @@ namespace json {
                     first = false;
                 }
                 else {
-                    out << ",\n"sv;
+                    out.put(',');
+                    ctx.PrintNewLine();
                 }
                 inner_ctx.PrintIndent();
                 PrintNode(node, inner_ctx);
             }
-            out.put('\n');
+            ctx.PrintNewLine();
             ctx.PrintIndent();
             out.put(']');
         }
@@ -306,7 +756,8 @@ namespace json {
         template <>
         void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
             std::ostream& out = ctx.out;
-            out << "{\n"sv;
+            out.put('{');
+            ctx.PrintNewLine();
             bool first = true;
             auto inner_ctx = ctx.Indented();
             for (const auto& [key, node] : nodes) {
@@ -314,14 +765,15 @@ namespace json {
                     first = false;
                 }
                 else {
-                    out << ",\n"sv;
+                    out.put(',');
+                    ctx.PrintNewLine();
                 }
                 inner_ctx.PrintIndent();
                 PrintString(key, ctx.out);
-                out << ": "sv;
+                out << ctx.KeySeparator();
                 PrintNode(node, inner_ctx);
             }
-            out.put('\n');
+            ctx.PrintNewLine();
             ctx.PrintIndent();
             out.put('}');
         }
@@ -337,11 +789,214 @@ namespace json {
     }  // namespace
 
     Document Load(std::istream& input) {
-        return Document{ LoadNode(input) };
+        auto arena = std::make_shared<std::pmr::monotonic_buffer_resource>();
+        Node root = LoadNode(input, arena.get());
+        return Document{ std::move(root), std::move(arena) };
+    }
+
+    Document Load(std::string_view input) {
+        auto arena = std::make_shared<std::pmr::monotonic_buffer_resource>();
+        DomBuilder builder(arena.get());
+        Parse(input, builder);
+        return Document{ builder.Extract(), std::move(arena) };
+    }
+
+    void Parse(std::istream& input, Handler& handler) {
+        StreamSource source(input);
+        SaxParser<StreamSource>(source, handler).ParseValue();
+    }
+
+    void Parse(std::string_view input, Handler& handler) {
+        BufferSource source(input);
+        SaxParser<BufferSource>(source, handler).ParseValue();
     }
 
-    void Print(const Document& doc, std::ostream& output) {
-        PrintNode(doc.GetRoot(), PrintContext{ output });
+    OutputBuffer::OutputBuffer(std::ostream& target)
+            : target_(target) {
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+    }
+
+    OutputBuffer::~OutputBuffer() {
+        Flush();
+    }
+
+    void OutputBuffer::Flush() {
+        if (pptr() != pbase()) {
+            target_.write(pbase(), pptr() - pbase());
+            setp(buffer_.data(), buffer_.data() + buffer_.size());
+        }
+    }
+
+    OutputBuffer::int_type OutputBuffer::overflow(int_type ch) {
+        Flush();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize OutputBuffer::xsputn(const char* data, std::streamsize count) {
+        // Блок больше буфера (например, SVG-карта) уходит в целевой поток напрямую
+        if (count > epptr() - pptr()) {
+            Flush();
+            if (count >= static_cast<std::streamsize>(buffer_.size())) {
+                target_.write(data, count);
+                return count;
+            }
+        }
+        std::memcpy(pptr(), data, static_cast<size_t>(count));
+        pbump(static_cast<int>(count));
+        return count;
+    }
+
+    int OutputBuffer::sync() {
+        Flush();
+        target_.flush();
+        return target_ ? 0 : -1;
+    }
+
+    void Print(const Document& doc, std::ostream& output, Format format) {
+        OutputBuffer buffer(output);
+        std::ostream out(&buffer);
+        if (format == Format::COMPACT) {
+            PrintNode(doc.GetRoot(), PrintContext{ out, 0, 0, true });
+        }
+        else {
+            PrintNode(doc.GetRoot(), PrintContext{ out });
+        }
+    }
+
+    Writer::Writer(std::ostream& output, Format format, size_t depth)
+            : buffer_(output)
+            , out_(&buffer_)
+            , compact_(format == Format::COMPACT)
+            , depth_(depth) {
+    }
+
+    void Writer::Flush() {
+        buffer_.Flush();
+    }
+
+    // Выводит разделитель и отступ перед очередным значением так же, как PrintValue<Array>
+    void Writer::BeginValue() {
+        if (frames_.empty()) {
+            return;
+        }
+        Frame& frame = frames_.back();
+        if (frame.is_dict) {
+            if (!key_written_) {
+                throw std::logic_error("Value() in a dict without Key()"s);
+            }
+            key_written_ = false;
+            return;
+        }
+        BeginItem(frame);
+    }
+
+    void Writer::BeginItem(Frame& frame) {
+        const PrintContext ctx = WriterContext(out_, compact_, depth_ + frames_.size());
+        if (!frame.first) {
+            out_.put(',');
+            ctx.PrintNewLine();
+        }
+        frame.first = false;
+        ctx.PrintIndent();
+    }
+
+    Writer& Writer::Key(std::string_view key) {
+        if (frames_.empty() || !frames_.back().is_dict || key_written_) {
+            throw std::logic_error("Key() outside a dict"s);
+        }
+        BeginItem(frames_.back());
+        PrintString(key, out_);
+        out_ << WriterContext(out_, compact_, depth_ + frames_.size()).KeySeparator();
+        key_written_ = true;
+        return *this;
+    }
+
+    Writer& Writer::Value(std::nullptr_t) {
+        return Value(Node{ nullptr });
+    }
+
+    Writer& Writer::Value(bool value) {
+        return Value(Node{ value });
+    }
+
+    Writer& Writer::Value(int value) {
+        return Value(Node{ value });
+    }
+
+    Writer& Writer::Value(double value) {
+        return Value(Node{ value });
+    }
+
+    Writer& Writer::Value(const Node& node) {
+        BeginValue();
+        PrintNode(node, WriterContext(out_, compact_, depth_ + frames_.size()));
+        FlushIfComplete();
+        return *this;
+    }
+
+    Writer& Writer::StringValue(std::string_view value) {
+        BeginValue();
+        PrintString(value, out_);
+        FlushIfComplete();
+        return *this;
+    }
+
+    Writer& Writer::RawValue(std::string_view json) {
+        BeginValue();
+        out_.write(json.data(), static_cast<std::streamsize>(json.size()));
+        FlushIfComplete();
+        return *this;
+    }
+
+    Writer& Writer::StartArray() {
+        BeginValue();
+        out_.put('[');
+        WriterContext(out_, compact_, depth_ + frames_.size()).PrintNewLine();
+        frames_.push_back({ false, true });
+        return *this;
+    }
+
+    Writer& Writer::StartDict() {
+        BeginValue();
+        out_.put('{');
+        WriterContext(out_, compact_, depth_ + frames_.size()).PrintNewLine();
+        frames_.push_back({ true, true });
+        return *this;
+    }
+
+    Writer& Writer::EndArray() {
+        EndContainer(false);
+        out_.put(']');
+        FlushIfComplete();
+        return *this;
+    }
+
+    Writer& Writer::EndDict() {
+        EndContainer(true);
+        out_.put('}');
+        FlushIfComplete();
+        return *this;
+    }
+
+    void Writer::EndContainer(bool is_dict) {
+        if (frames_.empty() || frames_.back().is_dict != is_dict || key_written_) {
+            throw std::logic_error(is_dict ? "EndDict() outside a dict"s : "EndArray() outside an array"s);
+        }
+        frames_.pop_back();
+        const PrintContext ctx = WriterContext(out_, compact_, depth_ + frames_.size());
+        ctx.PrintNewLine();
+        ctx.PrintIndent();
+    }
+
+    // Корневое значение дописано — отдаём накопленное в целевой поток
+    void Writer::FlushIfComplete() {
+        if (frames_.empty()) {
+            Flush();
+        }
     }
 
 }  // namespace json
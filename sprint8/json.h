@@ -1,16 +1,32 @@
 #pragma once
 
+#include <array>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
+#ifdef JSON_FLAT_DICT
+#include "json_flat_dict.h"
+#endif
+
 namespace json {
 
     class Node;
-    using Dict = std::map<std::string, Node>;
-    using Array = std::vector<Node>;
+    // Контейнеры берут память из memory_resource: у загруженного документа это его арена,
+    // у остальных узлов — ресурс по умолчанию (обычная куча)
+    using String = std::pmr::string;
+#ifdef JSON_FLAT_DICT
+    using Dict = FlatDict<Node>;
+#else
+    using Dict = std::pmr::map<String, Node, std::less<>>;
+#endif
+    using Array = std::pmr::vector<Node>;
 
     class ParsingError : public std::runtime_error {
     public:
@@ -18,12 +34,14 @@ namespace json {
     };
 
     class Node final
-            : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+            : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, String> {
     public:
         using variant::variant;
         using Value = variant;
 
         Node(Value value) : variant(std::move(value)) {}
+        Node(const std::string& value) : variant(String(value)) {}
+        Node(std::string_view value) : variant(String(value)) {}
 
         bool IsInt() const {
             return std::holds_alternative<int>(*this);
@@ -79,15 +97,15 @@ namespace json {
         }
 
         bool IsString() const {
-            return std::holds_alternative<std::string>(*this);
+            return std::holds_alternative<String>(*this);
         }
-        const std::string& AsString() const {
+        const String& AsString() const {
             using namespace std::literals;
             if (!IsString()) {
                 throw std::logic_error("Not a string"s);
             }
 
-            return std::get<std::string>(*this);
+            return std::get<String>(*this);
         }
 
         bool IsDict() const {
@@ -124,11 +142,19 @@ namespace json {
                 : root_(std::move(root)) {
         }
 
+        // Документ, узлы которого размещены в арене arena; арена живёт, пока жив документ
+        Document(Node root, std::shared_ptr<std::pmr::memory_resource> arena)
+                : arena_(std::move(arena))
+                , root_(std::move(root)) {
+        }
+
         const Node& GetRoot() const {
             return root_;
         }
 
     private:
+        // Объявлена раньше root_, чтобы освобождаться после всех узлов
+        std::shared_ptr<std::pmr::memory_resource> arena_;
         Node root_;
     };
 
@@ -140,8 +166,118 @@ namespace json {
         return !(lhs == rhs);
     }
 
+    // Узлы загруженного документа размещаются в его собственной монотонной арене:
+    // соседние узлы лежат рядом в памяти, а весь документ освобождается разом
     Document Load(std::istream& input);
 
-    void Print(const Document& doc, std::ostream& output);
+    // Разбирает документ из непрерывного буфера (строки или отображённого в память файла)
+    Document Load(std::string_view input);
+
+    // Обработчик событий потокового (SAX) разбора. Строки, переданные в OnString и OnKey,
+    // действительны только во время вызова
+    class Handler {
+    public:
+        virtual void OnNull() = 0;
+        virtual void OnBool(bool value) = 0;
+        virtual void OnInt(int value) = 0;
+        virtual void OnDouble(double value) = 0;
+        virtual void OnString(std::string_view value) = 0;
+        virtual void OnStartArray() = 0;
+        virtual void OnEndArray() = 0;
+        virtual void OnStartDict() = 0;
+        virtual void OnKey(std::string_view key) = 0;
+        virtual void OnEndDict() = 0;
+
+    protected:
+        ~Handler() = default;
+    };
+
+    // Разбирает один JSON-документ, сообщая о его элементах обработчику по мере чтения.
+    // Дерево Node не строится; символы берутся напрямую из буфера потока
+    void Parse(std::istream& input, Handler& handler);
+
+    // То же для непрерывного буфера: строки без escape-последовательностей передаются
+    // обработчику как view прямо в input, числа разбираются std::from_chars
+    void Parse(std::string_view input, Handler& handler);
+
+    // PRETTY — с переводами строк и отступом в 4 пробела, COMPACT — без единого лишнего символа
+    enum class Format {
+        PRETTY,
+        COMPACT,
+    };
+
+    // Буфер вывода: символы копятся в массиве и уходят в целевой поток крупными блоками
+    class OutputBuffer final : public std::streambuf {
+    public:
+        explicit OutputBuffer(std::ostream& target);
+        ~OutputBuffer() override;
+
+        void Flush();
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char* data, std::streamsize count) override;
+        int sync() override;
+
+    private:
+        std::ostream& target_;
+        std::array<char, 64 * 1024> buffer_;
+    };
+
+    void Print(const Document& doc, std::ostream& output, Format format = Format::PRETTY);
+
+    // Пишет JSON прямо в поток по мере вызовов, не строя дерево Node. Вывод совпадает с Print.
+    // Ключи словаря выводятся в порядке вызовов, поэтому для совпадения с Print их нужно
+    // передавать по возрастанию
+    class Writer {
+    public:
+        // depth — вложенность, на которой начинается вывод: отступы будут такими же, как у значения
+        // на этой глубине. Так можно заранее напечатать элемент и позже вставить его через RawValue
+        explicit Writer(std::ostream& output, Format format = Format::PRETTY, size_t depth = 0);
+
+        // Вывод копится во внутреннем буфере и сбрасывается после корневого значения,
+        // при вызове Flush и при разрушении Writer
+        void Flush();
+
+        Writer& Key(std::string_view key);
+        Writer& Value(std::nullptr_t);
+        Writer& Value(bool value);
+        Writer& Value(int value);
+        Writer& Value(double value);
+        Writer& Value(const Node& node);
+
+        // Строки любого вида (литералы, std::string, json::String) выводятся без копирования
+        template <typename Str, std::enable_if_t<std::is_convertible_v<const Str&, std::string_view>, int> = 0>
+        Writer& Value(const Str& value) {
+            return StringValue(value);
+        }
+
+        // Вставляет уже напечатанный JSON (в том же формате и на той же глубине) как очередное значение
+        Writer& RawValue(std::string_view json);
+
+        Writer& StartArray();
+        Writer& EndArray();
+        Writer& StartDict();
+        Writer& EndDict();
+
+    private:
+        struct Frame {
+            bool is_dict = false;
+            bool first = true;
+        };
+
+        Writer& StringValue(std::string_view value);
+        void BeginValue();
+        void BeginItem(Frame& frame);
+        void EndContainer(bool is_dict);
+        void FlushIfComplete();
+
+        OutputBuffer buffer_;
+        std::ostream out_;
+        bool compact_ = false;
+        size_t depth_ = 0;
+        std::vector<Frame> frames_;
+        bool key_written_ = false;
+    };
 
 }  // namespace json
@@ -7,8 +7,9 @@ using namespace std::literals;
 
 namespace json {
 
-    Builder::Builder()
-            : root_()
+    Builder::Builder(std::pmr::memory_resource* resource)
+            : resource_(resource)
+            , root_()
             , nodes_stack_{ &root_ }
     {}
 
@@ -19,7 +20,7 @@ namespace json {
         return std::move(root_);
     }
 
-    Builder::DictValueContext Builder::Key(std::string key) {
+    Builder::DictValueContext Builder::Key(std::string_view key) {
         Node::Value& host_value = GetCurrentValue();
 
         if (!std::holds_alternative<Dict>(host_value)) {
@@ -27,18 +28,18 @@ namespace json {
         }
 
         nodes_stack_.push_back(
-                &std::get<Dict>(host_value)[std::move(key)]
+                &std::get<Dict>(host_value).try_emplace(String(key, resource_)).first->second
         );
         return BaseContext{ *this };
     }
 
-    Builder::BaseContext Builder::Value(Node::Value value) {
-        AddObject(std::move(value), true);
+    Builder::BaseContext Builder::Value(Node value) {
+        AddObject(std::move(value.GetValue()), true);
         return *this;
     }
 
     Builder::DictItemContext Builder::StartDict() {
-        AddObject(Dict{}, false);
+        AddObject(Dict(resource_), false);
         return BaseContext{ *this };
     }
 
@@ -51,7 +52,7 @@ namespace json {
     }
 
     Builder::ArrayItemContext Builder::StartArray() {
-        AddObject(Array{}, false);
+        AddObject(Array(resource_), false);
         return ArrayItemContext{ *this };
     }
 
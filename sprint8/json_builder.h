@@ -1,6 +1,8 @@
 #pragma once
 
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "json.h"
 
@@ -14,16 +16,19 @@ namespace json {
         class ArrayItemContext;
 
     public:
-        Builder();
+        // Словари, массивы и ключи создаются в resource; например, в арене,
+        // которую вызывающий освобождает целиком после использования результата
+        explicit Builder(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
         Node Build();
-        DictValueContext Key(std::string key);
-        BaseContext Value(Node::Value value);
+        DictValueContext Key(std::string_view key);
+        BaseContext Value(Node value);
         DictItemContext StartDict();
         ArrayItemContext StartArray();
         BaseContext EndDict();
         BaseContext EndArray();
 
     private:
+        std::pmr::memory_resource* resource_;
         Node root_;
         std::vector<Node*> nodes_stack_;
 
@@ -39,10 +44,10 @@ namespace json {
             Node Build() {
                 return builder_.Build();
             }
-            DictValueContext Key(std::string key) {
-                return builder_.Key(std::move(key));
+            DictValueContext Key(std::string_view key) {
+                return builder_.Key(key);
             }
-            BaseContext Value(Node::Value value) {
+            BaseContext Value(Node value) {
                 return builder_.Value(std::move(value));
             }
             DictItemContext StartDict() {
@@ -64,9 +69,9 @@ namespace json {
         class DictValueContext : public BaseContext {
         public:
             DictValueContext(BaseContext base) : BaseContext(base) {}
-            DictItemContext Value(Node::Value value) { return BaseContext::Value(std::move(value)); }
+            DictItemContext Value(Node value) { return BaseContext::Value(std::move(value)); }
             Node Build() = delete;
-            DictValueContext Key(std::string key) = delete;
+            DictValueContext Key(std::string_view key) = delete;
             BaseContext EndDict() = delete;
             BaseContext EndArray() = delete;
         };
@@ -75,7 +80,7 @@ namespace json {
         public:
             DictItemContext(BaseContext base) : BaseContext(base) {}
             Node Build() = delete;
-            BaseContext Value(Node::Value value) = delete;
+            BaseContext Value(Node value) = delete;
             BaseContext EndArray() = delete;
             DictItemContext StartDict() = delete;
             ArrayItemContext StartArray() = delete;
@@ -84,9 +89,9 @@ namespace json {
         class ArrayItemContext : public BaseContext {
         public:
             ArrayItemContext(BaseContext base) : BaseContext(base) {}
-            ArrayItemContext Value(Node::Value value) { return BaseContext::Value(std::move(value)); }
+            ArrayItemContext Value(Node value) { return BaseContext::Value(std::move(value)); }
             Node Build() = delete;
-            DictValueContext Key(std::string key) = delete;
+            DictValueContext Key(std::string_view key) = delete;
             BaseContext EndDict() = delete;
         };
     };
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+    // Словарь на отсортированном по ключу векторе. Повторяет ту часть интерфейса std::map,
+    // которой пользуется библиотека, и так же обходит ключи по возрастанию, но хранит элементы
+    // подряд и ищет двоичным поиском. Выгоден для множества маленьких словарей.
+    // Value может быть неполным типом в точке объявления псевдонима
+    template <typename Value>
+    class FlatDict {
+    public:
+        using key_type = std::pmr::string;
+        using mapped_type = Value;
+        using value_type = std::pair<key_type, Value>;
+        using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+        using iterator = typename std::pmr::vector<value_type>::iterator;
+        using const_iterator = typename std::pmr::vector<value_type>::const_iterator;
+
+        FlatDict() = default;
+
+        explicit FlatDict(const allocator_type& alloc)
+                : items_(alloc) {
+        }
+
+        iterator begin() {
+            return items_.begin();
+        }
+        iterator end() {
+            return items_.end();
+        }
+        const_iterator begin() const {
+            return items_.begin();
+        }
+        const_iterator end() const {
+            return items_.end();
+        }
+
+        size_t size() const {
+            return items_.size();
+        }
+        bool empty() const {
+            return items_.empty();
+        }
+
+        iterator find(std::string_view key) {
+            const auto it = LowerBound(key);
+            return it != items_.end() && it->first == key ? it : items_.end();
+        }
+        const_iterator find(std::string_view key) const {
+            return const_cast<FlatDict*>(this)->find(key);
+        }
+
+        size_t count(std::string_view key) const {
+            return find(key) == end() ? 0 : 1;
+        }
+
+        Value& at(std::string_view key) {
+            const auto it = find(key);
+            if (it == items_.end()) {
+                throw std::out_of_range("FlatDict::at");
+            }
+            return it->second;
+        }
+        const Value& at(std::string_view key) const {
+            return const_cast<FlatDict*>(this)->at(key);
+        }
+
+        template <typename... Args>
+        std::pair<iterator, bool> try_emplace(key_type key, Args&&... args) {
+            auto it = LowerBound(key);
+            if (it != items_.end() && it->first == key) {
+                return { it, false };
+            }
+            it = items_.emplace(it, std::piecewise_construct,
+                                std::forward_as_tuple(std::move(key)),
+                                std::forward_as_tuple(std::forward<Args>(args)...));
+            return { it, true };
+        }
+
+        std::pair<iterator, bool> emplace(key_type key, Value value) {
+            return try_emplace(std::move(key), std::move(value));
+        }
+
+        Value& operator[](key_type key) {
+            return try_emplace(std::move(key)).first->second;
+        }
+
+        bool operator==(const FlatDict& other) const {
+            return items_ == other.items_;
+        }
+        bool operator!=(const FlatDict& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        iterator LowerBound(std::string_view key) {
+            return std::lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view key) {
+                return std::string_view(item.first) < key;
+            });
+        }
+
+        std::pmr::vector<value_type> items_;
+    };
+
+}  // namespace json
@@ -2,12 +2,262 @@
 #include "request_handler.h"
 #include "map_renderer.h"
 #include "json_builder.h" // Include the json_builder header
+#include "parallel.h"
+#include "serialization.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 
 namespace json_reader {
 
+    using namespace std::literals;
+
+    namespace {
+
+        // Сколько ответов на поток строится за одну пачку при параллельной обработке
+        constexpr size_t STAT_BATCH_PER_THREAD = 64;
+
+        // Ответы на эти запросы зависят только от типа и имени и потому кэшируются
+        bool IsCacheable(std::string_view type) {
+            return type == "Stop"sv || type == "Bus"sv;
+        }
+
+        // Sink для кэша ответов: печатает ответ как элемент массива ответов
+        // и запоминает, где в тексте стоит значение request_id
+        class RequestIdMarkingWriter {
+        public:
+            explicit RequestIdMarkingWriter(json::Format format)
+                    : writer_(stream_, format, 1) {}
+
+            void Key(std::string_view key) {
+                writer_.Key(key);
+                if (key == "request_id"sv) {
+                    writer_.Flush();
+                    id_begin_ = stream_.tellp();
+                    marking_ = true;
+                }
+            }
+
+            template <typename Item>
+            void Value(const Item& value) {
+                writer_.Value(value);
+                if (marking_) {
+                    writer_.Flush();
+                    id_end_ = stream_.tellp();
+                    marking_ = false;
+                }
+            }
+
+            void StartArray() {
+                writer_.StartArray();
+            }
+
+            void EndArray() {
+                writer_.EndArray();
+            }
+
+            void StartDict() {
+                writer_.StartDict();
+            }
+
+            void EndDict() {
+                writer_.EndDict();
+            }
+
+            response_cache::CachedResponse Finish() {
+                writer_.Flush();
+                const std::string text = std::move(stream_).str();
+                return { text.substr(0, static_cast<size_t>(id_begin_)), text.substr(static_cast<size_t>(id_end_)) };
+            }
+
+        private:
+            std::ostringstream stream_;
+            json::Writer writer_;
+            std::streampos id_begin_ = 0;
+            std::streampos id_end_ = 0;
+            bool marking_ = false;
+        };
+
+        // Есть ли запросы, которым нужен каталог целиком, а не только образ базы
+        bool NeedsCatalogue(const json::Array& stat_requests) {
+            return std::any_of(stat_requests.begin(), stat_requests.end(), [](const json::Node& request) {
+                const std::string_view type = request.AsDict().at("type").AsString();
+                return type != "Stop"sv && type != "Bus"sv;
+            });
+        }
+
+        // Разбирает корневой словарь запроса потоково. Элементы массивов верхнего уровня
+        // (base_requests, stat_requests) собираются в Node по одному и сразу отдаются в item_callback,
+        // остальные значения верхнего уровня целиком передаются в value_callback.
+        // Узлы живут в арене, которая сбрасывается после каждого колбэка, — сохранять их нужно копией
+        class RequestStreamHandler final : public json::Handler {
+        public:
+            using ItemCallback = std::function<void(std::string_view section, const json::Node& item)>;
+            using ValueCallback = std::function<void(std::string_view key, const json::Node& value)>;
+
+            RequestStreamHandler(ItemCallback item_callback, ValueCallback value_callback)
+                    : item_callback_(std::move(item_callback))
+                    , value_callback_(std::move(value_callback)) {
+            }
+
+            void OnNull() override {
+                BeginValue();
+                builder_->Value(nullptr);
+                FinishValue();
+            }
+
+            void OnBool(bool value) override {
+                BeginValue();
+                builder_->Value(value);
+                FinishValue();
+            }
+
+            void OnInt(int value) override {
+                BeginValue();
+                builder_->Value(value);
+                FinishValue();
+            }
+
+            void OnDouble(double value) override {
+                BeginValue();
+                builder_->Value(value);
+                FinishValue();
+            }
+
+            void OnString(std::string_view value) override {
+                BeginValue();
+                builder_->Value(json::String(value, &item_arena_));
+                FinishValue();
+            }
+
+            void OnStartArray() override {
+                if (depth_ == 0) {
+                    throw json::ParsingError("Request root must be a dict"s);
+                }
+                if (depth_ == 1) {
+                    // Массив верхнего уровня не собирается целиком
+                    ++depth_;
+                    return;
+                }
+                BeginValue();
+                builder_->StartArray();
+                ++depth_;
+            }
+
+            void OnEndArray() override {
+                --depth_;
+                if (builder_) {
+                    builder_->EndArray();
+                    FinishValue();
+                }
+            }
+
+            void OnStartDict() override {
+                if (depth_ > 0) {
+                    BeginValue();
+                    builder_->StartDict();
+                }
+                ++depth_;
+            }
+
+            void OnKey(std::string_view key) override {
+                if (builder_) {
+                    builder_->Key(key);
+                }
+                else {
+                    section_ = key;
+                }
+            }
+
+            void OnEndDict() override {
+                --depth_;
+                if (depth_ > 0) {
+                    builder_->EndDict();
+                    FinishValue();
+                }
+            }
+
+        private:
+            void BeginValue() {
+                if (depth_ == 0) {
+                    throw json::ParsingError("Request root must be a dict"s);
+                }
+                if (!builder_) {
+                    builder_.emplace(&item_arena_);
+                    capture_depth_ = depth_;
+                }
+            }
+
+            void FinishValue() {
+                if (!builder_ || depth_ != capture_depth_) {
+                    return;
+                }
+                {
+                    const json::Node node = builder_->Build();
+                    builder_.reset();
+                    if (depth_ == 1) {
+                        value_callback_(section_, node);
+                    }
+                    else {
+                        item_callback_(section_, node);
+                    }
+                }
+                // Узел уже разрушен: память элемента возвращается в начальный буфер арены
+                item_arena_.release();
+            }
+
+            ItemCallback item_callback_;
+            ValueCallback value_callback_;
+            std::array<std::byte, 4096> item_buffer_;
+            std::pmr::monotonic_buffer_resource item_arena_{ item_buffer_.data(), item_buffer_.size() };
+            std::optional<json::Builder> builder_;
+            std::string section_;
+            size_t depth_ = 0;
+            size_t capture_depth_ = 0;
+        };
+
+    }  // namespace
+
+    // Необязательная область запроса Map: "bbox" с границами в градусах или "tile" с номером тайла XYZ
+    std::optional<map_renderer::MapArea> JsonReader::ParseMapArea(const json::Dict& request_map) const {
+        if (const auto bbox = request_map.find("bbox"); bbox != request_map.end()) {
+            const auto& dict = bbox->second.AsDict();
+            // Пустая или перевёрнутая область дала бы нулевой или отрицательный масштаб проекции
+            const auto get_range = [&dict](const char* min_name, const char* max_name) {
+                const double min = dict.at(min_name).AsDouble();
+                const double max = dict.at(max_name).AsDouble();
+                if (!(min < max)) {
+                    throw std::out_of_range("Bbox "s + min_name + " must be less than " + max_name);
+                }
+                return std::pair(min, max);
+            };
+            const auto [min_lat, max_lat] = get_range("min_lat", "max_lat");
+            const auto [min_lng, max_lng] = get_range("min_lng", "max_lng");
+            return map_renderer::MapArea{ { { min_lat, min_lng }, { max_lat, max_lng } } };
+        }
+        if (const auto tile = request_map.find("tile"); tile != request_map.end()) {
+            const auto& dict = tile->second.AsDict();
+            const auto get_field = [&dict](const char* name) {
+                const int value = dict.at(name).AsInt();
+                if (value < 0) {
+                    throw std::out_of_range("Tile "s + name + " must not be negative");
+                }
+                return static_cast<uint32_t>(value);
+            };
+            return map_renderer::GetTileArea(get_field("x"), get_field("y"), get_field("zoom"));
+        }
+        return std::nullopt;
+    }
+
     RenderSettings JsonReader::ParseRenderSettings(const json::Dict& dict) {
         RenderSettings settings;
         settings.width = dict.at("width").AsDouble();
@@ -42,14 +292,14 @@ namespace json_reader {
             }
         }
         else {
-            settings.underlayer_color = underlayer_color.AsString();
+            settings.underlayer_color = std::string(underlayer_color.AsString());
         }
         settings.underlayer_width = dict.at("underlayer_width").AsDouble();
 
         const auto& color_palette = dict.at("color_palette").AsArray();
         for (const auto& color_node : color_palette) {
             if (color_node.IsString()) {
-                settings.color_palette.emplace_back(color_node.AsString());
+                settings.color_palette.emplace_back(std::string(color_node.AsString()));
             }
             else if (color_node.IsArray()) {
                 const auto& color_array = color_node.AsArray();
@@ -74,6 +324,13 @@ namespace json_reader {
         return settings;
     }
 
+    transport_router::RoutingSettings JsonReader::ParseRoutingSettings(const json::Dict& dict) {
+        transport_router::RoutingSettings settings;
+        settings.bus_wait_time = dict.at("bus_wait_time").AsInt();
+        settings.bus_velocity = dict.at("bus_velocity").AsDouble();
+        return settings;
+    }
+
     json::Node JsonReader::ProcessRequests(const json::Node& input) {
         const auto& root = input.AsDict();
 
@@ -81,112 +338,423 @@ namespace json_reader {
         const auto& stat_requests = root.at("stat_requests").AsArray();
         const auto& render_settings_dict = root.at("render_settings").AsDict();
         render_settings_ = ParseRenderSettings(render_settings_dict);
+        if (const auto routing_settings = root.find("routing_settings"); routing_settings != root.end()) {
+            routing_settings_ = ParseRoutingSettings(routing_settings->second.AsDict());
+        }
 
         ProcessBaseRequests(base_requests);
+        BuildRouter();
         return json::Node{ ProcessStatRequests(stat_requests) };
     }
 
-    void JsonReader::ProcessBaseRequests(const json::Array& base_requests) {
-        std::unordered_set<std::string> stops_in_routes;
+    void JsonReader::ProcessRequests(std::istream& input, std::ostream& output) {
+        ProcessRequestEvents([&input](json::Handler& handler) {
+            json::Parse(input, handler);
+        }, output);
+    }
 
-        for (const auto& request : base_requests) {
-            const auto& request_map = request.AsDict();
-            const std::string& type = request_map.at("type").AsString();
-            if (type == "Stop") {
-                const std::string& name = request_map.at("name").AsString();
-                const double latitude = request_map.at("latitude").AsDouble();
-                const double longitude = request_map.at("longitude").AsDouble();
+    void JsonReader::ProcessRequests(std::string_view input, std::ostream& output) {
+        ProcessRequestEvents([input](json::Handler& handler) {
+            json::Parse(input, handler);
+        }, output);
+    }
 
-                domain::Stop stop{ name, {latitude, longitude} };
-                tc_.AddStop(stop);
-            }
+    void JsonReader::ProcessRequestEvents(const std::function<void(json::Handler&)>& parse, std::ostream& output) {
+        const RunMode mode = processing_settings_.mode;
+        json::Array stat_requests;
+        RequestStreamHandler handler(
+                [this, mode, &stat_requests](std::string_view section, const json::Node& item) {
+                    if (section == "base_requests"sv && mode != RunMode::PROCESS_REQUESTS) {
+                        ProcessBaseRequest(item.AsDict());
+                    }
+                    else if (section == "stat_requests"sv && mode != RunMode::MAKE_BASE) {
+                        // Копия размещается в обычной куче и переживает сброс арены
+                        stat_requests.push_back(item);
+                    }
+                },
+                [this](std::string_view key, const json::Node& value) {
+                    if (key == "render_settings"sv) {
+                        render_settings_ = ParseRenderSettings(value.AsDict());
+                    }
+                    else if (key == "routing_settings"sv) {
+                        routing_settings_ = ParseRoutingSettings(value.AsDict());
+                    }
+                    else if (key == "serialization_settings"sv) {
+                        serialization_file_ = std::string(value.AsDict().at("file").AsString());
+                    }
+                });
+        parse(handler);
+
+        switch (mode) {
+            case RunMode::FULL:
+                FinishBaseRequests();
+                break;
+            case RunMode::MAKE_BASE:
+                FinishBaseRequests();
+                SaveBase();
+                return;
+            case RunMode::PROCESS_REQUESTS:
+                LoadBase(NeedsCatalogue(stat_requests));
+                break;
         }
+        BuildRouter();
+        WriteStatResponses(stat_requests, output);
+    }
 
-        for (const auto& request : base_requests) {
-            const auto& request_map = request.AsDict();
-            const std::string& type = request_map.at("type").AsString();
-            if (type == "Bus") {
-                const std::string& name = request_map.at("name").AsString();
-                const auto& stops_node = request_map.at("stops").AsArray();
-                std::vector<std::string_view> stops;
-                for (const auto& stop_node : stops_node) {
-                    stops.emplace_back(stop_node.AsString());
-                    stops_in_routes.insert(stop_node.AsString());
-                }
-                const bool is_roundtrip = request_map.at("is_roundtrip").AsBool();
+    void JsonReader::SaveBase() const {
+        std::ofstream file(GetSerializationFile(), std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot open snapshot file for writing: "s + serialization_file_);
+        }
+        serialization::SaveSnapshot(tc_, { render_settings_, routing_settings_ }, file);
+    }
 
-                domain::Bus bus{ name, stops, is_roundtrip };
-                tc_.AddBus(bus);
-            }
+    // Образ базы отображается в память и читается на месте; каталог из него
+    // собирается, только если среди запросов есть не обслуживаемые образом напрямую
+    void JsonReader::LoadBase(bool materialize_catalogue) {
+        base_image_.reset();
+        base_file_.emplace(GetSerializationFile());
+        base_image_.emplace(base_file_->GetData());
+        if (materialize_catalogue) {
+            serialization::LoadCatalogue(*base_image_, tc_, processing_settings_.thread_count);
         }
+        auto settings = serialization::LoadSettings(*base_image_);
+        render_settings_ = std::move(settings.render_settings);
+        routing_settings_ = settings.routing_settings;
+    }
 
+    const std::string& JsonReader::GetSerializationFile() const {
+        if (serialization_file_.empty()) {
+            throw std::runtime_error("serialization_settings.file is required in this mode");
+        }
+        return serialization_file_;
+    }
+
+    void JsonReader::ProcessBaseRequests(const json::Array& base_requests) {
         for (const auto& request : base_requests) {
-            const auto& request_map = request.AsDict();
-            const std::string& type = request_map.at("type").AsString();
-            if (type == "Stop") {
-                const std::string& name = request_map.at("name").AsString();
-                const auto& road_distances = request_map.at("road_distances").AsDict();
-                for (const auto& [neighbor_name, distance_node] : road_distances) {
-                    tc_.SetDistance(name, neighbor_name, distance_node.AsInt());
-                }
+            ProcessBaseRequest(request.AsDict());
+        }
+        FinishBaseRequests();
+    }
+
+    // Остановки добавляются сразу; маршруты и расстояния ссылаются на остановки,
+    // которые могут встретиться позже, поэтому откладываются до FinishBaseRequests
+    void JsonReader::ProcessBaseRequest(const json::Dict& request_map) {
+        const std::string_view type = request_map.at("type").AsString();
+        if (type == "Stop") {
+            const std::string_view name = request_map.at("name").AsString();
+            const double latitude = request_map.at("latitude").AsDouble();
+            const double longitude = request_map.at("longitude").AsDouble();
+
+            domain::Stop stop{ name, {latitude, longitude} };
+            tc_.AddStop(stop);
+
+            const auto& road_distances = request_map.at("road_distances").AsDict();
+            for (const auto& [neighbor_name, distance_node] : road_distances) {
+                pending_distances_.push_back({ std::string(name), std::string(neighbor_name), distance_node.AsInt() });
             }
         }
-        tc_.UpdateFilteredStops(stops_in_routes);
+        else if (type == "Bus") {
+            PendingBus bus;
+            bus.name = request_map.at("name").AsString();
+            for (const auto& stop_node : request_map.at("stops").AsArray()) {
+                bus.stops.emplace_back(stop_node.AsString());
+            }
+            bus.is_roundtrip = request_map.at("is_roundtrip").AsBool();
+            pending_buses_.push_back(std::move(bus));
+        }
     }
 
-    json::Array JsonReader::ProcessStatRequests(const json::Array& stat_requests) {
-        json::Array responses;
-        request_handler::RequestHandler handler(tc_);
+    void JsonReader::FinishBaseRequests() {
+        for (const auto& bus : pending_buses_) {
+            const std::vector<std::string_view> stops(bus.stops.begin(), bus.stops.end());
+            tc_.AddBus(bus.name, stops, bus.is_roundtrip);
+        }
+        for (const auto& distance : pending_distances_) {
+            tc_.SetDistance(distance.from, distance.to, distance.distance);
+        }
+        pending_buses_.clear();
+        pending_distances_.clear();
+        tc_.Finalize(processing_settings_.thread_count);
+    }
 
-        for (const auto& request : stat_requests) {
-            const auto& request_map = request.AsDict();
-            const int request_id = request_map.at("id").AsInt();
-            const std::string& type = request_map.at("type").AsString();
+    void JsonReader::BuildRouter() {
+        router_.reset();
+        if (routing_settings_) {
+            router_.emplace(tc_, *routing_settings_);
+            if (processing_settings_.precompute_routes) {
+                router_->Precompute(processing_settings_.thread_count);
+            }
+        }
+    }
 
-            json::Builder response_builder;
-            response_builder.StartDict()
-                    .Key("request_id").Value(request_id);
+    json::Array JsonReader::ProcessStatRequests(const json::Array& stat_requests) const {
+        const request_handler::RequestHandler handler(tc_, router_ ? &*router_ : nullptr,
+                                                      base_image_ ? &*base_image_ : nullptr);
+        return BuildStatResponses(stat_requests, handler);
+    }
 
-            if (type == "Stop") {
-                const std::string& name = request_map.at("name").AsString();
-                auto buses_opt = handler.GetBusesByStop(name);
-                if (!buses_opt) {
-                    response_builder.Key("error_message").Value("not found");
+    void JsonReader::WriteStatResponses(const json::Array& stat_requests, std::ostream& output) const {
+        const request_handler::RequestHandler handler(tc_, router_ ? &*router_ : nullptr,
+                                                      base_image_ ? &*base_image_ : nullptr);
+        if (response_cache_) {
+            // Данные могли измениться с прошлого вызова
+            response_cache_->Clear();
+        }
+        json::Writer writer(output, processing_settings_.output_format);
+        writer.StartArray();
+        if (processing_settings_.thread_count == 1) {
+            std::string response;
+            for (const auto& request : stat_requests) {
+                if (FindCachedStatResponse(request.AsDict(), handler, response)) {
+                    writer.RawValue(response);
                 }
                 else {
-                    const auto& buses = *buses_opt;
-                    json::Array buses_node;
-                    for (const auto& bus : buses) {
-                        buses_node.push_back(bus.name);
-                    }
-                    response_builder.Key("buses").Value(buses_node);
+                    WriteStatResponse(request.AsDict(), handler, writer);
                 }
             }
-            else if (type == "Bus") {
-                const std::string& name = request_map.at("name").AsString();
-                try {
-                    domain::BusInfo bus_info = handler.GetBusInfo(name);
-                    response_builder.Key("curvature").Value(bus_info.curvature)
-                            .Key("route_length").Value(static_cast<int>(bus_info.len))
-                            .Key("stop_count").Value(static_cast<int>(bus_info.count_stops))
-                            .Key("unique_stop_count").Value(static_cast<int>(bus_info.unique_count_stops));
-                }
-                catch (const std::out_of_range&) {
-                    response_builder.Key("error_message").Value("not found");
+        }
+        else {
+            // Ответы печатаются параллельно пачками и сразу выводятся по порядку,
+            // так что в памяти одновременно держится только одна пачка
+            const size_t thread_count = processing_settings_.thread_count == 0
+                                        ? parallel::DefaultThreadCount()
+                                        : processing_settings_.thread_count;
+            const size_t batch_size = thread_count * STAT_BATCH_PER_THREAD;
+            // Потоки создаются один раз на все пачки
+            parallel::WorkerPool workers(thread_count);
+            std::vector<std::string> responses;
+            for (size_t begin = 0; begin < stat_requests.size(); begin += batch_size) {
+                const size_t end = std::min(stat_requests.size(), begin + batch_size);
+                responses.resize(end - begin);
+                workers.ForEachChunk(responses.size(),
+                                     [this, &stat_requests, &responses, &handler, begin](size_t chunk_begin,
+                                                                                          size_t chunk_end) {
+                    for (size_t i = chunk_begin; i < chunk_end; ++i) {
+                        SerializeStatResponse(stat_requests[begin + i].AsDict(), handler, responses[i]);
+                    }
+                });
+                for (const auto& response : responses) {
+                    writer.RawValue(response);
                 }
             }
-            else if (type == "Map") {
-                std::ostringstream map_stream;
-                map_renderer::RenderMap(tc_, map_stream, render_settings_);
-                const std::string map_svg = map_stream.str();
+        }
+        writer.EndArray();
+    }
 
-                response_builder.Key("map").Value(map_svg);
-            }
+    // Текст ответа как элемента массива ответов — из кэша или напечатанный заново
+    void JsonReader::SerializeStatResponse(const json::Dict& request_map, const request_handler::RequestHandler& handler,
+                                           std::string& output) const {
+        if (FindCachedStatResponse(request_map, handler, output)) {
+            return;
+        }
+        std::ostringstream stream;
+        {
+            json::Writer writer(stream, processing_settings_.output_format, 1);
+            WriteStatResponse(request_map, handler, writer);
+        }
+        output = std::move(stream).str();
+    }
+
+    // false, если кэш выключен или запрос не кэшируется. При промахе ответ печатается
+    // с меткой на месте request_id и сохраняется; затем в него подставляется id запроса
+    bool JsonReader::FindCachedStatResponse(const json::Dict& request_map,
+                                            const request_handler::RequestHandler& handler,
+                                            std::string& output) const {
+        const std::string_view type = request_map.at("type").AsString();
+        if (!response_cache_ || !IsCacheable(type)) {
+            return false;
+        }
+        const std::string_view name = request_map.at("name").AsString();
+        auto cached = response_cache_->Find(type, name);
+        if (!cached) {
+            RequestIdMarkingWriter marking_writer(processing_settings_.output_format);
+            WriteStatResponse(request_map, handler, marking_writer);
+            cached = std::make_shared<const response_cache::CachedResponse>(marking_writer.Finish());
+            response_cache_->Insert(type, name, cached);
+        }
+
+        char id_buffer[16];
+        const auto id_end = std::to_chars(id_buffer, id_buffer + sizeof(id_buffer), request_map.at("id").AsInt()).ptr;
+        output.assign(cached->prefix);
+        output.append(id_buffer, id_end);
+        output.append(cached->suffix);
+        return true;
+    }
 
-            responses.push_back(response_builder.EndDict().Build());
+    std::optional<response_cache::CacheStats> JsonReader::GetResponseCacheStats() const {
+        if (!response_cache_) {
+            return std::nullopt;
         }
+        return response_cache_->GetStats();
+    }
+
+    std::optional<size_t> JsonReader::GetCachedRoutesBytes() const {
+        if (!router_) {
+            return std::nullopt;
+        }
+        return router_->GetCachedRoutesBytes();
+    }
+
+    json::Array JsonReader::BuildStatResponses(const json::Array& stat_requests,
+                                               const request_handler::RequestHandler& handler) const {
+        json::Array responses(stat_requests.size());
+
+        // После загрузки каталог только читается, поэтому ответы можно строить параллельно:
+        // каждый поток заполняет свой непрерывный участок responses
+        parallel::ForEachChunk(responses.size(), processing_settings_.thread_count,
+                               [this, &stat_requests, &responses, &handler](size_t chunk_begin, size_t chunk_end) {
+            for (size_t i = chunk_begin; i < chunk_end; ++i) {
+                json::Builder builder;
+                WriteStatResponse(stat_requests[i].AsDict(), handler, builder);
+                responses[i] = builder.Build();
+            }
+        });
 
         return responses;
     }
 
+    // Sink — json::Builder или json::Writer. Ключи выводятся по возрастанию,
+    // чтобы потоковый вывод совпадал с печатью построенного дерева
+    template <typename Sink>
+    void JsonReader::WriteStatResponse(const json::Dict& request_map, const request_handler::RequestHandler& handler,
+                                       Sink& sink) const {
+        const int request_id = request_map.at("id").AsInt();
+        const std::string_view type = request_map.at("type").AsString();
+
+        sink.StartDict();
+        auto write_not_found = [&sink] {
+            sink.Key("error_message");
+            sink.Value("not found");
+        };
+
+        if (type == "Stop") {
+            const auto buses_opt = handler.GetBusesByStop(request_map.at("name").AsString());
+            if (!buses_opt) {
+                write_not_found();
+            }
+            else {
+                sink.Key("buses");
+                sink.StartArray();
+                for (const std::string_view bus : *buses_opt) {
+                    sink.Value(bus);
+                }
+                sink.EndArray();
+            }
+            sink.Key("request_id");
+            sink.Value(request_id);
+        }
+        else if (type == "Bus") {
+            const auto bus_info = handler.GetBusStat(request_map.at("name").AsString());
+            if (!bus_info) {
+                write_not_found();
+                sink.Key("request_id");
+                sink.Value(request_id);
+            }
+            else {
+                sink.Key("curvature");
+                sink.Value(bus_info->curvature);
+                sink.Key("request_id");
+                sink.Value(request_id);
+                sink.Key("route_length");
+                sink.Value(static_cast<int>(bus_info->len));
+                sink.Key("stop_count");
+                sink.Value(static_cast<int>(bus_info->count_stops));
+                sink.Key("unique_stop_count");
+                sink.Value(static_cast<int>(bus_info->unique_count_stops));
+            }
+        }
+        else if (type == "Map") {
+            sink.Key("map");
+            if (const auto area = ParseMapArea(request_map)) {
+                std::ostringstream map_stream;
+                map_renderer_.RenderArea(render_settings_, *area, map_stream);
+                sink.Value(std::move(map_stream).str());
+            }
+            else {
+                sink.Value(*map_renderer_.GetMap(render_settings_));
+            }
+            sink.Key("request_id");
+            sink.Value(request_id);
+        }
+        else if (type == "Route") {
+            const auto route = handler.BuildRoute(request_map.at("from").AsString(), request_map.at("to").AsString());
+            if (!route) {
+                write_not_found();
+                sink.Key("request_id");
+                sink.Value(request_id);
+            }
+            else {
+                sink.Key("items");
+                sink.StartArray();
+                for (const auto& item : route->items) {
+                    sink.StartDict();
+                    if (item.type == transport_router::RouteItemType::WAIT) {
+                        sink.Key("stop_name");
+                        sink.Value(item.name);
+                        sink.Key("time");
+                        sink.Value(item.time);
+                        sink.Key("type");
+                        sink.Value("Wait");
+                    }
+                    else {
+                        sink.Key("bus");
+                        sink.Value(item.name);
+                        sink.Key("span_count");
+                        sink.Value(item.span_count);
+                        sink.Key("time");
+                        sink.Value(item.time);
+                        sink.Key("type");
+                        sink.Value("Bus");
+                    }
+                    sink.EndDict();
+                }
+                sink.EndArray();
+                sink.Key("request_id");
+                sink.Value(request_id);
+                sink.Key("total_time");
+                sink.Value(route->total_time);
+            }
+        }
+        else if (type == "StopsInRadius") {
+            const geo::Coordinates center{ request_map.at("latitude").AsDouble(), request_map.at("longitude").AsDouble() };
+            const double radius = request_map.at("radius").AsDouble();
+
+            sink.Key("request_id");
+            sink.Value(request_id);
+            sink.Key("stops");
+            sink.StartArray();
+            for (const auto& [name, distance] : handler.GetStopsWithinRadius(center, radius)) {
+                sink.StartDict();
+                sink.Key("distance");
+                sink.Value(distance);
+                sink.Key("stop_name");
+                sink.Value(name);
+                sink.EndDict();
+            }
+            sink.EndArray();
+        }
+        else if (type == "NearestStop") {
+            const geo::Coordinates center{ request_map.at("latitude").AsDouble(), request_map.at("longitude").AsDouble() };
+            if (const auto nearest = handler.GetNearestStop(center)) {
+                sink.Key("distance");
+                sink.Value(nearest->distance);
+                sink.Key("request_id");
+                sink.Value(request_id);
+                sink.Key("stop_name");
+                sink.Value(nearest->name);
+            }
+            else {
+                write_not_found();
+                sink.Key("request_id");
+                sink.Value(request_id);
+            }
+        }
+        else {
+            sink.Key("request_id");
+            sink.Value(request_id);
+        }
+        sink.EndDict();
+    }
+
 }  // namespace json_reader
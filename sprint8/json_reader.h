@@ -1,41 +1,127 @@
 #pragma once
 
+#include "catalogue_image.h"
 #include "json.h"
 #include "transport_catalogue.h"
 #include "svg.h"
+#include "map_renderer.h"
+#include "mapped_file.h"
+#include "request_handler.h"
+#include "response_cache.h"
+#include "transport_router.h"
+#include <functional>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace json_reader {
 
-    struct RenderSettings {
-        double width = 0;
-        double height = 0;
-        double padding = 0;
-        double line_width = 0;
-        double stop_radius = 0;
-        svg::Point bus_label_offset = { 0, 0 };
-        svg::Point stop_label_offset = { 0, 0 };
-        int bus_label_font_size = 0;
-        int stop_label_font_size = 0;
-        svg::Color underlayer_color = "none";
-        double underlayer_width = 0;
-        std::vector<svg::Color> color_palette;
+    using map_renderer::RenderSettings;
+
+    // FULL — база и запросы в одном входе; MAKE_BASE — только сохранить базу в файл
+    // serialization_settings.file; PROCESS_REQUESTS — загрузить базу из файла и ответить на stat_requests
+    enum class RunMode {
+        FULL,
+        MAKE_BASE,
+        PROCESS_REQUESTS,
+    };
+
+    // Параметры обработки, задаются из командной строки
+    struct ProcessingSettings {
+        RunMode mode = RunMode::FULL;
+        // Число рабочих потоков; 1 — всё в основном потоке, 0 — по числу ядер
+        size_t thread_count = 1;
+        // Формат ответа на stat_requests
+        json::Format output_format = json::Format::PRETTY;
+        // Считать маршруты из всех остановок сразу после загрузки, а не при первом запросе.
+        // Держит в памяти дерево путей на каждую остановку, то есть O(V²) для V вершин графа
+        bool precompute_routes = false;
+        // Сколько напечатанных ответов на Stop и Bus хранить для повторных запросов; 0 — не кэшировать
+        size_t response_cache_size = 0;
     };
 
     class JsonReader {
     public:
-        JsonReader(transport_catalogue::TransportCatalogue& tc) : tc_(tc) {}
+        JsonReader(transport_catalogue::TransportCatalogue& tc, ProcessingSettings processing_settings = {})
+                : tc_(tc)
+                , processing_settings_(processing_settings) {
+            if (processing_settings_.response_cache_size > 0) {
+                response_cache_.emplace(processing_settings_.response_cache_size);
+            }
+        }
 
         json::Node ProcessRequests(const json::Node& input);
 
+        // Читает запрос потоково: base_requests обрабатываются по одному элементу,
+        // не дожидаясь построения дерева всего документа. Ответы пишутся в output по мере готовности
+        void ProcessRequests(std::istream& input, std::ostream& output);
+
+        // То же для запроса, целиком лежащего в памяти (например, в отображённом файле)
+        void ProcessRequests(std::string_view input, std::ostream& output);
+
+        // Счётчики кэша ответов; nullopt, если кэш выключен
+        std::optional<response_cache::CacheStats> GetResponseCacheStats() const;
+
+        // Память под посчитанные маршруты; nullopt, если маршрутизатор не строился
+        std::optional<size_t> GetCachedRoutesBytes() const;
+
 
     private:
+        struct PendingBus {
+            std::string name;
+            std::vector<std::string> stops;
+            bool is_roundtrip = false;
+        };
+
+        struct PendingDistance {
+            std::string from;
+            std::string to;
+            int distance = 0;
+        };
+
         RenderSettings ParseRenderSettings(const json::Dict& dict);
+        transport_router::RoutingSettings ParseRoutingSettings(const json::Dict& dict);
+        std::optional<map_renderer::MapArea> ParseMapArea(const json::Dict& request_map) const;
+        void ProcessRequestEvents(const std::function<void(json::Handler&)>& parse, std::ostream& output);
         void ProcessBaseRequests(const json::Array& base_requests);
-        json::Array ProcessStatRequests(const json::Array& stat_requests);
+        void ProcessBaseRequest(const json::Dict& request_map);
+        void FinishBaseRequests();
+        void BuildRouter();
+        void SaveBase() const;
+        void LoadBase(bool materialize_catalogue);
+        const std::string& GetSerializationFile() const;
+        json::Array ProcessStatRequests(const json::Array& stat_requests) const;
+        void WriteStatResponses(const json::Array& stat_requests, std::ostream& output) const;
+        void SerializeStatResponse(const json::Dict& request_map, const request_handler::RequestHandler& handler,
+                                   std::string& output) const;
+        bool FindCachedStatResponse(const json::Dict& request_map, const request_handler::RequestHandler& handler,
+                                    std::string& output) const;
+        json::Array BuildStatResponses(const json::Array& stat_requests,
+                                       const request_handler::RequestHandler& handler) const;
+        template <typename Sink>
+        void WriteStatResponse(const json::Dict& request_map, const request_handler::RequestHandler& handler,
+                               Sink& sink) const;
 
         transport_catalogue::TransportCatalogue& tc_;
         RenderSettings render_settings_;
+        ProcessingSettings processing_settings_;
+        map_renderer::MapRenderer map_renderer_{ tc_, processing_settings_.thread_count };
+        std::optional<transport_router::RoutingSettings> routing_settings_;
+        std::string serialization_file_;
+        // Строится перед ответом на stat_requests, если заданы routing_settings
+        std::optional<transport_router::TransportRouter> router_;
+        // Образ базы в режиме PROCESS_REQUESTS; смотрит в отображённый файл
+        std::optional<mapped_file::MappedFile> base_file_;
+        std::optional<catalogue_image::CatalogueImage> base_image_;
+        // Кэш сам защищён мьютексом, поэтому пополняется и из константных методов
+        mutable std::optional<response_cache::ResponseCache> response_cache_;
+
+        // Данные base_requests, которые нельзя добавить в каталог до загрузки всех остановок
+        std::vector<PendingBus> pending_buses_;
+        std::vector<PendingDistance> pending_distances_;
     };
 
 }  // namespace json_reader
\ No newline at end of file
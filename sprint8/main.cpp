@@ -1,17 +1,141 @@
 #include "json_reader.h"
 #include "transport_catalogue.h"
-#include "json.h"
+#include "mapped_file.h"
+#include <charconv>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
 
-int main() {
-    transport_catalogue::TransportCatalogue tc;
-    json_reader::JsonReader reader(tc);
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define MAIN_HAS_GETRUSAGE
+#endif
+
+using namespace std::literals;
+
+namespace {
+
+    void PrintUsage(std::ostream& stream) {
+        stream << "Usage: transport_catalogue [make_base | process_requests] [--threads N] [--compact] [--precompute-routes]"
+                  " [--memory-report] [--response-cache N] [--cache-report]\n"sv;
+    }
+
+    // Неотрицательное целое без знака и посторонних символов; иначе value не меняется
+    bool ParseCount(std::string_view text, size_t& value) {
+        size_t parsed = 0;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+        if (error != std::errc{} || end != text.data() + text.size()) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    // Пиковый объём резидентной памяти процесса в байтах; 0, если узнать его нельзя
+    size_t GetPeakResidentBytes() {
+#ifdef MAIN_HAS_GETRUSAGE
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+#ifdef __APPLE__
+        return static_cast<size_t>(usage.ru_maxrss);
+#else
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+        return 0;
+#endif
+    }
 
-    json::Document input_doc = json::Load(std::cin);
+    void PrintCacheReport(const response_cache::CacheStats& stats, std::ostream& stream) {
+        stream << "Response cache: hits "sv << stats.hits << ", misses "sv << stats.misses
+               << ", evictions "sv << stats.evictions << '\n';
+    }
+
+    void PrintMemoryReport(const transport_catalogue::MemoryUsage& usage, std::optional<size_t> cached_routes_bytes,
+                           std::ostream& stream) {
+        const auto print = [&stream](std::string_view name, size_t bytes) {
+            stream << name << ": "sv << bytes << '\n';
+        };
+        stream << "Catalogue memory, bytes\n"sv;
+        print("  stops"sv, usage.stops);
+        print("  buses"sv, usage.buses);
+        print("  names"sv, usage.names);
+        print("  name index"sv, usage.name_index);
+        print("  stop buses"sv, usage.stop_buses);
+        print("  distances"sv, usage.distances);
+        print("  bus stats"sv, usage.bus_infos);
+        print("  stop index"sv, usage.stop_index);
+        print("  total"sv, usage.Total());
+        if (cached_routes_bytes) {
+            // Растёт с каждым новым источником запросов Route; с --precompute-routes — O(V²)
+            print("Cached routes memory, bytes"sv, *cached_routes_bytes);
+        }
+        print("Peak resident memory, bytes"sv, GetPeakResidentBytes());
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    json_reader::ProcessingSettings processing_settings;
+    bool memory_report = false;
+    bool cache_report = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i == 1 && arg == "make_base"sv) {
+            processing_settings.mode = json_reader::RunMode::MAKE_BASE;
+        }
+        else if (i == 1 && arg == "process_requests"sv) {
+            processing_settings.mode = json_reader::RunMode::PROCESS_REQUESTS;
+        }
+        else if (arg == "--threads"sv && i + 1 < argc && ParseCount(argv[i + 1], processing_settings.thread_count)) {
+            ++i;
+        }
+        else if (arg == "--compact"sv) {
+            processing_settings.output_format = json::Format::COMPACT;
+        }
+        else if (arg == "--precompute-routes"sv) {
+            processing_settings.precompute_routes = true;
+        }
+        else if (arg == "--memory-report"sv) {
+            memory_report = true;
+        }
+        else if (arg == "--response-cache"sv && i + 1 < argc
+                 && ParseCount(argv[i + 1], processing_settings.response_cache_size)) {
+            ++i;
+        }
+        else if (arg == "--cache-report"sv) {
+            cache_report = true;
+        }
+        else {
+            PrintUsage(std::cerr);
+            return 1;
+        }
+    }
+
+    std::ios::sync_with_stdio(false);
+
+    transport_catalogue::TransportCatalogue tc;
+    json_reader::JsonReader reader(tc, processing_settings);
 
-    json::Node output = reader.ProcessRequests(input_doc.GetRoot());
+    // Если stdin перенаправлен из файла, он разбирается прямо из отображённой памяти
+    if (const auto input_file = mapped_file::MappedFile::FromDescriptor(0)) {
+        reader.ProcessRequests(input_file->GetData(), std::cout);
+    }
+    else {
+        reader.ProcessRequests(std::cin, std::cout);
+    }
 
-    json::Print(json::Document{ output }, std::cout);
+    // Отчёты идут в stderr, чтобы не смешиваться с ответом
+    std::cout.flush();
+    if (memory_report) {
+        PrintMemoryReport(tc.GetMemoryUsage(), reader.GetCachedRoutesBytes(), std::cerr);
+    }
+    if (const auto cache_stats = reader.GetResponseCacheStats(); cache_report && cache_stats) {
+        PrintCacheReport(*cache_stats, std::cerr);
+    }
 
     return 0;
 }
@@ -1,74 +1,328 @@
 #include "map_renderer.h"
+#include "parallel.h"
 #include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
 
 namespace map_renderer {
 
-    void RenderMap(const transport_catalogue::TransportCatalogue& tc, std::ostream& output, const json_reader::RenderSettings& settings) {
-        std::vector<geo::Coordinates> coordinates;
-        for (const auto& [name, stop] : tc.GetStops()) {
-            if (!tc.GetBusesByStop(name).has_value()) continue;
-            coordinates.emplace_back(stop.coordinates);
+    namespace {
+
+        constexpr double PI = 3.14159265358979323846;
+
+        // Наибольшая по модулю широта, которую покрывают тайлы Web Mercator
+        constexpr double MAX_MERCATOR_LAT = 85.05112877980659;
+
+        // Растягивает область на весь холст без отступов. Масштабы по осям независимы,
+        // так что углы области всегда попадают в углы холста
+        class AreaProjector {
+        public:
+            AreaProjector(const MapArea& area, double width, double height)
+                    : mercator_(area.projection == AreaProjection::WEB_MERCATOR)
+                    , min_lng_(area.bounds.min.lng)
+                    , max_y_(ProjectLat(area.bounds.max.lat)) {
+                const double lng_span = area.bounds.max.lng - min_lng_;
+                const double y_span = max_y_ - ProjectLat(area.bounds.min.lat);
+                x_scale_ = geo::IsZero(lng_span) ? 0 : width / lng_span;
+                y_scale_ = geo::IsZero(y_span) ? 0 : height / y_span;
+            }
+
+            svg::Point operator()(geo::Coordinates coords) const {
+                return { (coords.lng - min_lng_) * x_scale_, (max_y_ - ProjectLat(coords.lat)) * y_scale_ };
+            }
+
+        private:
+            double ProjectLat(double lat) const {
+                if (!mercator_) {
+                    return lat;
+                }
+                lat = std::clamp(lat, -MAX_MERCATOR_LAT, MAX_MERCATOR_LAT);
+                return std::log(std::tan(PI / 4 + lat * PI / 360));
+            }
+
+            bool mercator_;
+            double min_lng_;
+            double max_y_;
+            double x_scale_ = 0;
+            double y_scale_ = 0;
+        };
+
+        struct MapBus {
+            const domain::Bus* bus;
+            // Позиция среди всех непустых маршрутов по возрастанию имён; определяет цвет
+            size_t color_index;
+        };
+
+        // Всё, что нужно слоям карты: остановки и маршруты по возрастанию имён и проекции остановок
+        struct MapData {
+            const std::deque<domain::Stop>& stops;
+            // Остановки, через которые проходит хотя бы один маршрут
+            std::vector<domain::StopId> route_stops;
+            std::vector<MapBus> buses;
+            // Проекции остановок. Если point_ids пуст, points индексируется идентификатором остановки;
+            // иначе в point_ids по возрастанию только рисуемые остановки, а в points — их проекции
+            std::vector<domain::StopId> point_ids;
+            std::vector<svg::Point> points;
+
+            svg::Point GetPoint(domain::StopId id) const {
+                if (point_ids.empty()) {
+                    return points[id];
+                }
+                return points[std::lower_bound(point_ids.begin(), point_ids.end(), id) - point_ids.begin()];
+            }
+        };
+
+        std::vector<const domain::Bus*> GetSortedBuses(const transport_catalogue::TransportCatalogue& tc) {
+            std::vector<const domain::Bus*> buses;
+            for (const auto& bus : tc.GetBuses()) {
+                if (bus.stops.empty()) continue;
+                buses.push_back(&bus);
+            }
+            std::sort(buses.begin(), buses.end(), [](const domain::Bus* lhs, const domain::Bus* rhs) {
+                return lhs->name < rhs->name;
+            });
+            return buses;
         }
 
-        SphereProjector projector(coordinates.begin(), coordinates.end(), settings.width, settings.height, settings.padding);
+        void SortStopsByName(MapData& data) {
+            const auto& stops = data.stops;
+            std::sort(data.route_stops.begin(), data.route_stops.end(), [&stops](domain::StopId lhs, domain::StopId rhs) {
+                return stops[lhs].name < stops[rhs].name;
+            });
+        }
+
+        MapData PrepareMapData(const transport_catalogue::TransportCatalogue& tc, const RenderSettings& settings) {
+            MapData data{ tc.GetStops(), {}, {}, {}, {} };
+            const auto& stops = data.stops;
+
+            std::vector<geo::Coordinates> coordinates;
+            for (domain::StopId id = 0; id < stops.size(); ++id) {
+                if (!tc.HasBuses(id)) continue;
+                data.route_stops.push_back(id);
+                coordinates.push_back(stops[id].coordinates);
+            }
+
+            SphereProjector projector(coordinates.begin(), coordinates.end(), settings.width, settings.height, settings.padding);
+
+            // Проекция каждой остановки считается один раз
+            data.points.resize(stops.size());
+            for (const domain::StopId id : data.route_stops) {
+                data.points[id] = projector(stops[id].coordinates);
+            }
+
+            SortStopsByName(data);
 
-        svg::Document doc;
+            const auto buses = GetSortedBuses(tc);
+            data.buses.reserve(buses.size());
+            for (size_t i = 0; i < buses.size(); ++i) {
+                data.buses.push_back({ buses[i], i });
+            }
+
+            return data;
+        }
 
-        std::vector<std::string> bus_names;
-        for (const auto& [name, bus] : tc.GetBuses()) {
-            bus_names.emplace_back(name);
+        // Задевает ли отрезок ab прямоугольник [0, width] × [0, height] (отсечение Лианга — Барски).
+        // Границы расширены на долю пикселя, чтобы остановки на краю области не терялись из-за округления
+        bool SegmentIntersectsCanvas(svg::Point a, svg::Point b, double width, double height) {
+            const double eps = 1e-9 * std::max({ width, height, 1.0 });
+            const double dx = b.x - a.x;
+            const double dy = b.y - a.y;
+            // Для каждой границы: p * t <= q
+            const double p[] = { -dx, dx, -dy, dy };
+            const double q[] = { a.x + eps, width + eps - a.x, a.y + eps, height + eps - a.y };
+            double t_min = 0;
+            double t_max = 1;
+            for (int i = 0; i < 4; ++i) {
+                if (p[i] == 0) {
+                    if (q[i] < 0) {
+                        return false;
+                    }
+                    continue;
+                }
+                const double t = q[i] / p[i];
+                if (p[i] < 0) {
+                    t_min = std::max(t_min, t);
+                }
+                else {
+                    t_max = std::min(t_max, t);
+                }
+                if (t_min > t_max) {
+                    return false;
+                }
+            }
+            return true;
         }
-        std::sort(bus_names.begin(), bus_names.end());
 
-        size_t color_index = 0;
+        bool BusIntersectsCanvas(const domain::Bus& bus, const std::deque<domain::Stop>& stops,
+                                 const AreaProjector& projector, const RenderSettings& settings) {
+            svg::Point previous = projector(stops[bus.stops.front()].coordinates);
+            if (bus.stops.size() == 1) {
+                return SegmentIntersectsCanvas(previous, previous, settings.width, settings.height);
+            }
+            for (size_t i = 1; i < bus.stops.size(); ++i) {
+                const svg::Point current = projector(stops[bus.stops[i]].coordinates);
+                if (SegmentIntersectsCanvas(previous, current, settings.width, settings.height)) {
+                    return true;
+                }
+                previous = current;
+            }
+            return false;
+        }
 
-        for (const auto& name : bus_names) {
-            const auto& bus = tc.GetBuses().at(name);
-            if (bus.stops.empty()) continue;
+        // Данные для части карты: остановки внутри area и все маршруты, отрезки которых её задевают.
+        // Кандидаты ищутся по пространственному индексу в области, расширенной на самый длинный
+        // отрезок маршрутов: так находятся и маршруты, проходящие область без остановок в ней
+        MapData PrepareAreaData(const transport_catalogue::TransportCatalogue& tc, const RenderSettings& settings,
+                                const MapArea& area, const std::vector<size_t>& bus_color_indices) {
+            MapData data{ tc.GetStops(), {}, {}, {}, {} };
+            const auto& stops = data.stops;
 
-            svg::Polyline polyline;
-            const auto& color = settings.color_palette[color_index % settings.color_palette.size()];
-            polyline.SetStrokeColor(color)
-                    .SetFillColor(svg::NoneColor)
-                    .SetStrokeWidth(settings.line_width)
-                    .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-                    .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+            const geo::Coordinates span = tc.GetMaxSegmentSpan();
+            const geo::BoundingBox search_box{
+                    { area.bounds.min.lat - span.lat, area.bounds.min.lng - span.lng },
+                    { area.bounds.max.lat + span.lat, area.bounds.max.lng + span.lng }
+            };
 
-            for (const auto& stop_name : bus.stops) {
-                const auto& stop = tc.GetStops().at(std::string(stop_name));
-                auto point = projector(stop.coordinates);
-                polyline.AddPoint(point);
+            std::vector<domain::BusId> bus_ids;
+            for (const domain::StopId id : tc.FindStopsInBox(search_box)) {
+                const auto stop_buses = tc.GetBusIdsByStop(id);
+                if (stop_buses.empty()) continue;
+                if (area.bounds.Contains(stops[id].coordinates)) {
+                    data.route_stops.push_back(id);
+                }
+                bus_ids.insert(bus_ids.end(), stop_buses.begin(), stop_buses.end());
             }
+            std::sort(bus_ids.begin(), bus_ids.end());
+            bus_ids.erase(std::unique(bus_ids.begin(), bus_ids.end()), bus_ids.end());
+
+            // Холст целиком занимает область, а не охват всех остановок
+            const AreaProjector projector(area, settings.width, settings.height);
 
-            if (!bus.is_circular) {
-                for (auto it = std::next(bus.stops.rbegin()); it != bus.stops.rend(); ++it) {
-                    const auto& stop = tc.GetStops().at(std::string(*it));
-                    auto point = projector(stop.coordinates);
-                    polyline.AddPoint(point);
+            for (const domain::BusId id : bus_ids) {
+                const domain::Bus& bus = tc.GetBus(id);
+                if (BusIntersectsCanvas(bus, stops, projector, settings)) {
+                    data.buses.push_back({ &bus, bus_color_indices[id] });
                 }
             }
+            std::sort(data.buses.begin(), data.buses.end(), [](const MapBus& lhs, const MapBus& rhs) {
+                return lhs.color_index < rhs.color_index;
+            });
 
-            doc.Add(std::move(polyline));
-            ++color_index;
+            // Линии маршрутов выходят за область, поэтому проецируются все их остановки, но только они
+            data.point_ids = data.route_stops;
+            for (const auto& [bus, color_index] : data.buses) {
+                data.point_ids.insert(data.point_ids.end(), bus->stops.begin(), bus->stops.end());
+            }
+            std::sort(data.point_ids.begin(), data.point_ids.end());
+            data.point_ids.erase(std::unique(data.point_ids.begin(), data.point_ids.end()), data.point_ids.end());
+            data.points.reserve(data.point_ids.size());
+            for (const domain::StopId id : data.point_ids) {
+                data.points.push_back(projector(stops[id].coordinates));
+            }
+
+            SortStopsByName(data);
+            return data;
         }
 
-        color_index = 0;
-        for (const auto& name : bus_names) {
-            const auto& bus = tc.GetBuses().at(name);
-            if (bus.stops.empty()) continue;
+        const svg::Color& GetBusColor(const RenderSettings& settings, size_t bus_index) {
+            return settings.color_palette[bus_index % settings.color_palette.size()];
+        }
+
+        // Слои карты; каждый рисует элементы [begin, end) своего списка
+
+        void RenderBusLines(const MapData& data, const RenderSettings& settings, size_t begin, size_t end,
+                            svg::StreamWriter& writer) {
+            for (size_t i = begin; i < end; ++i) {
+                const auto& bus = *data.buses[i].bus;
+
+                svg::Polyline polyline;
+                polyline.SetStrokeColor(GetBusColor(settings, data.buses[i].color_index))
+                        .SetFillColor(svg::NoneColor)
+                        .SetStrokeWidth(settings.line_width)
+                        .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
+                        .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
-            const auto& color = settings.color_palette[color_index % settings.color_palette.size()];
-            const auto& first_stop = tc.GetStops().at(std::string(bus.stops.front())).coordinates;
-            const auto& last_stop = tc.GetStops().at(std::string(bus.stops.back())).coordinates;
+                for (const auto stop_id : bus.stops) {
+                    polyline.AddPoint(data.GetPoint(stop_id));
+                }
+
+                if (!bus.is_circular) {
+                    for (auto it = std::next(bus.stops.rbegin()); it != bus.stops.rend(); ++it) {
+                        polyline.AddPoint(data.GetPoint(*it));
+                    }
+                }
+
+                writer.Add(polyline);
+            }
+        }
+
+        void RenderBusLabel(const RenderSettings& settings, svg::Point position, std::string_view label,
+                            const svg::Color& color, svg::StreamWriter& writer) {
+            svg::Text text_underlayer;
+            text_underlayer.SetPosition(position)
+                    .SetOffset(settings.bus_label_offset)
+                    .SetFontSize(settings.bus_label_font_size)
+                    .SetFontFamily("Verdana")
+                    .SetFontWeight("bold")
+                    .SetData(std::string(label))
+                    .SetFillColor(settings.underlayer_color)
+                    .SetStrokeColor(settings.underlayer_color)
+                    .SetStrokeWidth(settings.underlayer_width)
+                    .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
+                    .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+
+            svg::Text text;
+            text.SetPosition(position)
+                    .SetOffset(settings.bus_label_offset)
+                    .SetFontSize(settings.bus_label_font_size)
+                    .SetFontFamily("Verdana")
+                    .SetFontWeight("bold")
+                    .SetData(std::string(label))
+                    .SetFillColor(color);
+
+            writer.Add(text_underlayer);
+            writer.Add(text);
+        }
+
+        void RenderBusLabels(const MapData& data, const RenderSettings& settings, size_t begin, size_t end,
+                             svg::StreamWriter& writer) {
+            for (size_t i = begin; i < end; ++i) {
+                const auto& bus = *data.buses[i].bus;
+                const auto& color = GetBusColor(settings, data.buses[i].color_index);
+
+                RenderBusLabel(settings, data.GetPoint(bus.stops.front()), bus.name, color, writer);
+                if (!bus.is_circular && bus.stops.front() != bus.stops.back()) {
+                    RenderBusLabel(settings, data.GetPoint(bus.stops.back()), bus.name, color, writer);
+                }
+            }
+        }
+
+        void RenderStopPoints(const MapData& data, const RenderSettings& settings, size_t begin, size_t end,
+                              svg::StreamWriter& writer) {
+            for (size_t i = begin; i < end; ++i) {
+                svg::Circle circle;
+                circle.SetCenter(data.GetPoint(data.route_stops[i]))
+                        .SetRadius(settings.stop_radius)
+                        .SetFillColor("white");
+
+                writer.Add(circle);
+            }
+        }
+
+        void RenderStopLabels(const MapData& data, const RenderSettings& settings, size_t begin, size_t end,
+                              svg::StreamWriter& writer) {
+            for (size_t i = begin; i < end; ++i) {
+                const domain::StopId id = data.route_stops[i];
+                const auto& stop = data.stops[id];
 
-            auto draw_text = [&](const geo::Coordinates& coords, const std::string& label) {
                 svg::Text text_underlayer;
-                text_underlayer.SetPosition(projector(coords))
-                        .SetOffset(settings.bus_label_offset)
-                        .SetFontSize(settings.bus_label_font_size)
+                text_underlayer.SetPosition(data.GetPoint(id))
+                        .SetOffset(settings.stop_label_offset)
+                        .SetFontSize(settings.stop_label_font_size)
                         .SetFontFamily("Verdana")
-                        .SetFontWeight("bold")
-                        .SetData(label)
+                        .SetData(std::string(stop.name))
                         .SetFillColor(settings.underlayer_color)
                         .SetStrokeColor(settings.underlayer_color)
                         .SetStrokeWidth(settings.underlayer_width)
@@ -76,72 +330,141 @@ namespace map_renderer {
                         .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
                 svg::Text text;
-                text.SetPosition(projector(coords))
-                        .SetOffset(settings.bus_label_offset)
-                        .SetFontSize(settings.bus_label_font_size)
+                text.SetPosition(data.GetPoint(id))
+                        .SetOffset(settings.stop_label_offset)
+                        .SetFontSize(settings.stop_label_font_size)
                         .SetFontFamily("Verdana")
-                        .SetFontWeight("bold")
-                        .SetData(label)
-                        .SetFillColor(color);
+                        .SetData(std::string(stop.name))
+                        .SetFillColor("black");
 
-                doc.Add(std::move(text_underlayer));
-                doc.Add(std::move(text));
-            };
+                writer.Add(text_underlayer);
+                writer.Add(text);
+            }
+        }
+
+        struct Layer {
+            void (*render)(const MapData&, const RenderSettings&, size_t, size_t, svg::StreamWriter&);
+            bool by_stops;
 
-            draw_text(first_stop, bus.name);
-            if (!bus.is_circular && bus.stops.front() != bus.stops.back()) {
-                draw_text(last_stop, bus.name);
+            size_t Size(const MapData& data) const {
+                return by_stops ? data.route_stops.size() : data.buses.size();
             }
+        };
 
-            ++color_index;
-        }
+        // Слои в порядке наложения
+        const Layer LAYERS[] = {
+                { RenderBusLines, false },
+                { RenderBusLabels, false },
+                { RenderStopPoints, true },
+                { RenderStopLabels, true },
+        };
+
+        void RenderLayers(const MapData& data, const RenderSettings& settings, std::ostream& output, size_t thread_count) {
+            svg::StreamWriter writer(output);
+            writer.Begin();
+
+            if (thread_count == 0) {
+                thread_count = parallel::DefaultThreadCount();
+            }
+            if (thread_count <= 1) {
+                // Фигуры выводятся сразу, как только построены: память не растёт с размером карты
+                for (const auto& layer : LAYERS) {
+                    layer.render(data, settings, 0, layer.Size(data), writer);
+                }
+            }
+            else {
+                // Каждый слой делится на thread_count частей, которые рисуются в свои буферы.
+                // Задания чередуются по слоям, чтобы каждому потоку досталось по части каждого слоя
+                const size_t layer_count = std::size(LAYERS);
+                std::vector<std::string> parts(layer_count * thread_count);
+                parallel::ForEachChunk(parts.size(), thread_count, [&](size_t begin, size_t end) {
+                    for (size_t job = begin; job < end; ++job) {
+                        const Layer& layer = LAYERS[job % layer_count];
+                        const size_t part = job / layer_count;
+                        const size_t size = layer.Size(data);
+
+                        std::ostringstream part_stream;
+                        svg::StreamWriter part_writer(part_stream);
+                        layer.render(data, settings, size * part / thread_count, size * (part + 1) / thread_count, part_writer);
+                        parts[job] = std::move(part_stream).str();
+                    }
+                });
 
-        std::vector<std::string> stop_names;
-        for (const auto& [name, stop] : tc.GetStops()) {
-            if (tc.GetBusesByStop(name).has_value()) {
-                stop_names.push_back(name);
+                // Слои склеиваются в порядке наложения, части слоя — по порядку
+                for (size_t layer = 0; layer < layer_count; ++layer) {
+                    for (size_t part = 0; part < thread_count; ++part) {
+                        const std::string& text = parts[part * layer_count + layer];
+                        output.write(text.data(), static_cast<std::streamsize>(text.size()));
+                    }
+                }
             }
+
+            writer.End();
         }
-        std::sort(stop_names.begin(), stop_names.end());
 
-        for (const auto& name : stop_names) {
-            const auto& stop = tc.GetStops().at(name).coordinates;
-            svg::Circle circle;
-            circle.SetCenter(projector(stop))
-                    .SetRadius(settings.stop_radius)
-                    .SetFillColor("white");
+    }  // namespace
 
-            doc.Add(std::move(circle));
+    std::shared_ptr<const std::string> MapRenderer::GetMap(const RenderSettings& settings) const {
+        const uint64_t version = tc_.GetVersion();
+        std::lock_guard guard(map_mutex_);
+        if (!cached_map_ || cached_version_ != version || !(cached_settings_ == settings)) {
+            std::ostringstream map_stream;
+            RenderMap(tc_, map_stream, settings, thread_count_);
+            cached_map_ = std::make_shared<const std::string>(std::move(map_stream).str());
+            cached_version_ = version;
+            cached_settings_ = settings;
         }
+        return cached_map_;
+    }
 
-        for (const auto& name : stop_names) {
-            const auto& stop = tc.GetStops().at(name).coordinates;
+    void MapRenderer::RenderArea(const RenderSettings& settings, const MapArea& area, std::ostream& output) const {
+        const auto bus_color_indices = GetBusColorIndices();
+        RenderLayers(PrepareAreaData(tc_, settings, area, *bus_color_indices), settings, output, 1);
+    }
 
-            svg::Text text_underlayer;
-            text_underlayer.SetPosition(projector(stop))
-                    .SetOffset(settings.stop_label_offset)
-                    .SetFontSize(settings.stop_label_font_size)
-                    .SetFontFamily("Verdana")
-                    .SetData(name)
-                    .SetFillColor(settings.underlayer_color)
-                    .SetStrokeColor(settings.underlayer_color)
-                    .SetStrokeWidth(settings.underlayer_width)
-                    .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-                    .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+    std::shared_ptr<const std::vector<size_t>> MapRenderer::GetBusColorIndices() const {
+        const uint64_t version = tc_.GetVersion();
 
-            svg::Text text;
-            text.SetPosition(projector(stop))
-                    .SetOffset(settings.stop_label_offset)
-                    .SetFontSize(settings.stop_label_font_size)
-                    .SetFontFamily("Verdana")
-                    .SetData(name)
-                    .SetFillColor("black");
+        std::lock_guard guard(color_mutex_);
+        if (!bus_color_indices_ || bus_color_version_ != version) {
+            // Цвет маршрута зависит от его места среди всех маршрутов, поэтому на любом фрагменте
+            // карты он тот же, что и на карте целиком
+            const auto buses = GetSortedBuses(tc_);
+            std::vector<size_t> color_indices(tc_.GetBuses().size());
+            for (size_t i = 0; i < buses.size(); ++i) {
+                color_indices[tc_.FindBusId(buses[i]->name).value()] = i;
+            }
+            bus_color_indices_ = std::make_shared<const std::vector<size_t>>(std::move(color_indices));
+            bus_color_version_ = version;
+        }
+        return bus_color_indices_;
+    }
+
+    void RenderMap(const transport_catalogue::TransportCatalogue& tc, std::ostream& output, const RenderSettings& settings,
+                   size_t thread_count) {
+        RenderLayers(PrepareMapData(tc, settings), settings, output, thread_count);
+    }
 
-            doc.Add(std::move(text_underlayer));
-            doc.Add(std::move(text));
+    geo::BoundingBox GetTileBounds(uint32_t x, uint32_t y, uint32_t zoom) {
+        if (zoom >= 32) {
+            throw std::out_of_range("Tile zoom is out of range");
+        }
+        const double tile_count = std::ldexp(1.0, static_cast<int>(zoom));
+        if (x >= tile_count || y >= tile_count) {
+            throw std::out_of_range("Tile index is out of range");
         }
+        const auto lng = [tile_count](double tile_x) {
+            return tile_x / tile_count * 360.0 - 180.0;
+        };
+        // Обратная проекция Web Mercator; строки тайлов идут с севера на юг
+        const auto lat = [tile_count](double tile_y) {
+            return std::atan(std::sinh(PI * (1 - 2 * tile_y / tile_count))) * 180.0 / PI;
+        };
+        return { { lat(y + 1.0), lng(x) }, { lat(y), lng(x + 1.0) } };
+    }
 
-        doc.Render(output);
+    MapArea GetTileArea(uint32_t x, uint32_t y, uint32_t zoom) {
+        return { GetTileBounds(x, y, zoom), AreaProjection::WEB_MERCATOR };
     }
 
-} // namespace map_renderer
\ No newline at end of file
+} // namespace map_renderer
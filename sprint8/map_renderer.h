@@ -2,7 +2,11 @@
 
 #include "transport_catalogue.h"
 #include "svg.h"
-#include "json_reader.h"
+#include "geo.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 #include <optional>
 #include <algorithm>
@@ -78,6 +82,91 @@ private:
 
 namespace map_renderer {
 
-    void RenderMap(const transport_catalogue::TransportCatalogue& tc, std::ostream& output, const json_reader::RenderSettings& settings);
+    struct RenderSettings {
+        double width = 0;
+        double height = 0;
+        double padding = 0;
+        double line_width = 0;
+        double stop_radius = 0;
+        svg::Point bus_label_offset = { 0, 0 };
+        svg::Point stop_label_offset = { 0, 0 };
+        int bus_label_font_size = 0;
+        int stop_label_font_size = 0;
+        svg::Color underlayer_color = "none";
+        double underlayer_width = 0;
+        std::vector<svg::Color> color_palette;
 
-} // namespace map_renderer
\ No newline at end of file
+        bool operator==(const RenderSettings& other) const {
+            return width == other.width && height == other.height && padding == other.padding
+                   && line_width == other.line_width && stop_radius == other.stop_radius
+                   && bus_label_offset == other.bus_label_offset && stop_label_offset == other.stop_label_offset
+                   && bus_label_font_size == other.bus_label_font_size
+                   && stop_label_font_size == other.stop_label_font_size
+                   && underlayer_color == other.underlayer_color && underlayer_width == other.underlayer_width
+                   && color_palette == other.color_palette;
+        }
+    };
+
+    // Слои карты (линии маршрутов, названия маршрутов, остановки, названия остановок)
+    // рисуются частями в thread_count потоках (0 — по числу ядер) и склеиваются по порядку
+    void RenderMap(const transport_catalogue::TransportCatalogue& tc, std::ostream& output, const RenderSettings& settings,
+                   size_t thread_count = 1);
+
+    // Как широта части карты переводится в вертикаль холста
+    enum class AreaProjection {
+        // Пропорционально широте
+        LINEAR,
+        // Как у тайлов XYZ, чтобы соседние тайлы стыковались без искажений
+        WEB_MERCATOR,
+    };
+
+    // Часть карты: прямоугольник на местности и способ растянуть его на холст
+    struct MapArea {
+        geo::BoundingBox bounds;
+        AreaProjection projection = AreaProjection::LINEAR;
+    };
+
+    // Географическая область тайла XYZ (x, y, zoom) в проекции Web Mercator, как у OpenStreetMap
+    geo::BoundingBox GetTileBounds(uint32_t x, uint32_t y, uint32_t zoom);
+
+    MapArea GetTileArea(uint32_t x, uint32_t y, uint32_t zoom);
+
+    // Рисует карту и запоминает результат. Пока каталог не менялся (см. GetVersion)
+    // и настройки те же, повторные запросы получают готовую строку.
+    // Потокобезопасен: одновременные запросы карты целиком дождутся одной отрисовки,
+    // а части карты рисуются параллельно с ней
+    class MapRenderer {
+    public:
+        explicit MapRenderer(const transport_catalogue::TransportCatalogue& tc, size_t thread_count = 1)
+                : tc_(tc)
+                , thread_count_(thread_count) {}
+
+        std::shared_ptr<const std::string> GetMap(const RenderSettings& settings) const;
+
+        // Рисует только остановки внутри area и маршруты через них. Углы области совпадают с углами
+        // холста width×height, отступ padding не применяется, поэтому соседние области складываются
+        // в общую карту. Цвета маршрутов те же, что на карте целиком. Результат не кэшируется.
+        // Слои рисуются в вызывающем потоке: в отличие от карты целиком, части карты рисуются
+        // по одной на запрос, а запросы и так обрабатываются параллельно
+        void RenderArea(const RenderSettings& settings, const MapArea& area, std::ostream& output) const;
+
+    private:
+        std::shared_ptr<const std::vector<size_t>> GetBusColorIndices() const;
+
+        const transport_catalogue::TransportCatalogue& tc_;
+        size_t thread_count_;
+
+        // Отрисовка идёт под map_mutex_; цвета маршрутов защищены отдельно, чтобы части карты её не ждали
+        mutable std::mutex map_mutex_;
+        mutable std::shared_ptr<const std::string> cached_map_;
+        mutable uint64_t cached_version_ = 0;
+        // Копия настроек, с которыми нарисована cached_map_
+        mutable RenderSettings cached_settings_;
+
+        // Номер цвета для каждого маршрута, индексируется идентификатором маршрута
+        mutable std::mutex color_mutex_;
+        mutable std::shared_ptr<const std::vector<size_t>> bus_color_indices_;
+        mutable uint64_t bus_color_version_ = 0;
+    };
+
+} // namespace map_renderer
@@ -0,0 +1,126 @@
+#include "mapped_file.h"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_HAS_MMAP
+#endif
+
+namespace mapped_file {
+
+    using namespace std::literals;
+
+#ifdef MAPPED_FILE_HAS_MMAP
+
+    MappedFile::MappedFile(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file "s + path);
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat file "s + path);
+        }
+        try {
+            MapDescriptor(fd, static_cast<size_t>(info.st_size));
+        }
+        catch (...) {
+            ::close(fd);
+            throw;
+        }
+        // Отображение остаётся действительным и после закрытия дескриптора
+        ::close(fd);
+    }
+
+    std::optional<MappedFile> MappedFile::FromDescriptor(int fd) {
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            return std::nullopt;
+        }
+        MappedFile file;
+        file.MapDescriptor(fd, static_cast<size_t>(info.st_size));
+        return file;
+    }
+
+    void MappedFile::MapDescriptor(int fd, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Cannot map file into memory"s);
+        }
+        data_ = static_cast<const char*>(data);
+        size_ = size;
+        mapped_ = true;
+    }
+
+    void MappedFile::Reset() {
+        if (mapped_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+        fallback_.clear();
+    }
+
+#else
+
+    MappedFile::MappedFile(const std::string& path) {
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            throw std::runtime_error("Cannot open file "s + path);
+        }
+        fallback_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        data_ = fallback_.data();
+        size_ = fallback_.size();
+    }
+
+    std::optional<MappedFile> MappedFile::FromDescriptor(int) {
+        return std::nullopt;
+    }
+
+    void MappedFile::MapDescriptor(int, size_t) {
+        throw std::runtime_error("Memory mapping is not supported"s);
+    }
+
+    void MappedFile::Reset() {
+        data_ = nullptr;
+        size_ = 0;
+        fallback_.clear();
+    }
+
+#endif
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            mapped_ = std::exchange(other.mapped_, false);
+            fallback_ = std::move(other.fallback_);
+            size_ = std::exchange(other.size_, 0);
+            const char* data = std::exchange(other.data_, nullptr);
+            // Данные резервной копии переехали вместе со строкой
+            data_ = mapped_ ? data : fallback_.data();
+            other.fallback_.clear();
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() {
+        Reset();
+    }
+
+}  // namespace mapped_file
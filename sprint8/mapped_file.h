@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace mapped_file {
+
+    // Файл, отображённый в память только для чтения. Там, где mmap недоступен,
+    // содержимое читается в память целиком
+    class MappedFile {
+    public:
+        // Бросает std::runtime_error, если файл не удалось открыть
+        explicit MappedFile(const std::string& path);
+
+        // Отображает уже открытый дескриптор (например, stdin), если за ним обычный файл.
+        // Для каналов и терминалов возвращает nullopt — их нужно читать потоково
+        static std::optional<MappedFile> FromDescriptor(int fd);
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        std::string_view GetData() const {
+            return { data_, size_ };
+        }
+
+    private:
+        MappedFile() = default;
+        void MapDescriptor(int fd, size_t size);
+        void Reset();
+
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+        bool mapped_ = false;
+        std::string fallback_;
+    };
+
+}  // namespace mapped_file
@@ -0,0 +1,35 @@
+#include "name_pool.h"
+
+#include <cstring>
+
+namespace name_pool {
+
+    std::string_view NamePool::Add(std::string_view name) {
+        if (name.empty()) {
+            return {};
+        }
+        if (name.size() > free_size_) {
+            // Длинное имя получает отдельный блок, а начатый блок продолжает заполняться
+            if (name.size() > BLOCK_SIZE / 4) {
+                blocks_.push_back(std::make_unique<char[]>(name.size()));
+                allocated_bytes_ += name.size();
+                std::memcpy(blocks_.back().get(), name.data(), name.size());
+                return { blocks_.back().get(), name.size() };
+            }
+            blocks_.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+            allocated_bytes_ += BLOCK_SIZE;
+            free_ = blocks_.back().get();
+            free_size_ = BLOCK_SIZE;
+        }
+        char* const data = free_;
+        std::memcpy(data, name.data(), name.size());
+        free_ += name.size();
+        free_size_ -= name.size();
+        return { data, name.size() };
+    }
+
+    size_t NamePool::GetAllocatedBytes() const {
+        return allocated_bytes_ + blocks_.capacity() * sizeof(blocks_[0]);
+    }
+
+}  // namespace name_pool
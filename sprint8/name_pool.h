@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace name_pool {
+
+    // Общее хранилище имён. Строки копируются подряд в большие блоки, поэтому у имени нет
+    // ни своего выделения памяти, ни 32 байт std::string. Блоки не перемещаются:
+    // возвращённые представления действительны, пока жив пул
+    class NamePool {
+    public:
+        NamePool() = default;
+        NamePool(NamePool&&) = default;
+        NamePool& operator=(NamePool&&) = default;
+        NamePool(const NamePool&) = delete;
+        NamePool& operator=(const NamePool&) = delete;
+
+        std::string_view Add(std::string_view name);
+
+        // Сколько байт занимают блоки пула
+        size_t GetAllocatedBytes() const;
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        size_t allocated_bytes_ = 0;
+        // Свободное место в последнем блоке
+        char* free_ = nullptr;
+        size_t free_size_ = 0;
+    };
+
+}  // namespace name_pool
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <charconv>
+#include <ostream>
+
+namespace number_format {
+
+    // Число для вывода в поток через std::to_chars в локальный буфер.
+    // Запись совпадает с operator<< при настройках потока по умолчанию:
+    // double — как %g с 6 значащими цифрами, int — обычная десятичная запись
+    template <typename Value>
+    struct Number {
+        Value value;
+    };
+
+    template <typename Value>
+    Number(Value) -> Number<Value>;
+
+    inline std::ostream& operator<<(std::ostream& out, Number<double> number) {
+        char buffer[32];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), number.value,
+                                          std::chars_format::general, 6);
+        return out.write(buffer, result.ptr - buffer);
+    }
+
+    inline std::ostream& operator<<(std::ostream& out, Number<int> number) {
+        char buffer[16];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), number.value);
+        return out.write(buffer, result.ptr - buffer);
+    }
+
+}  // namespace number_format
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+    // Число потоков, если пользователь его не задал (thread_count == 0)
+    inline size_t DefaultThreadCount() {
+        return std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    // Делит диапазон [0, count) на непрерывные части и вызывает func(begin, end) для каждой
+    // в своём потоке. При thread_count == 1 всё выполняется в вызывающем потоке.
+    // Исключение из рабочего потока пробрасывается после завершения всех потоков.
+    // Если поток не удалось создать, уже запущенные дожидаются и ошибка пробрасывается
+    template <typename Func>
+    void ForEachChunk(size_t count, size_t thread_count, Func func) {
+        if (thread_count == 0) {
+            thread_count = DefaultThreadCount();
+        }
+        thread_count = std::min(thread_count, count);
+        if (thread_count <= 1) {
+            func(size_t{ 0 }, count);
+            return;
+        }
+
+        const size_t chunk_size = (count + thread_count - 1) / thread_count;
+        std::vector<std::exception_ptr> errors(thread_count);
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count);
+        const auto join_all = [&workers] {
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        };
+        try {
+            for (size_t i = 0; i < thread_count; ++i) {
+                const size_t begin = i * chunk_size;
+                const size_t end = std::min(count, begin + chunk_size);
+                if (begin >= end) {
+                    break;
+                }
+                workers.emplace_back([&func, &errors, i, begin, end] {
+                    try {
+                        func(begin, end);
+                    }
+                    catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                });
+            }
+        }
+        catch (...) {
+            join_all();
+            throw;
+        }
+        join_all();
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    // Постоянный набор потоков для многократных вызовов ForEachChunk: потоки создаются
+    // один раз, а не на каждый вызов. Вызывающий поток обрабатывает первую часть сам,
+    // поэтому рабочих потоков на один меньше thread_count (0 — по числу ядер)
+    class WorkerPool {
+    public:
+        explicit WorkerPool(size_t thread_count) {
+            if (thread_count == 0) {
+                thread_count = DefaultThreadCount();
+            }
+            try {
+                for (size_t i = 1; i < thread_count; ++i) {
+                    workers_.emplace_back([this, i] {
+                        WorkerLoop(i);
+                    });
+                }
+            }
+            catch (...) {
+                Stop();
+                throw;
+            }
+        }
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        ~WorkerPool() {
+            Stop();
+        }
+
+        // То же, что parallel::ForEachChunk, но на потоках набора. Вызовы не должны пересекаться
+        template <typename Func>
+        void ForEachChunk(size_t count, Func func) {
+            const size_t chunk_count = std::min(workers_.size() + 1, count);
+            if (chunk_count <= 1) {
+                func(size_t{ 0 }, count);
+                return;
+            }
+
+            const size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+            std::vector<std::exception_ptr> errors(workers_.size() + 1);
+            const std::function<void(size_t)> task = [&func, &errors, count, chunk_size](size_t index) {
+                const size_t begin = std::min(count, index * chunk_size);
+                const size_t end = std::min(count, begin + chunk_size);
+                if (begin >= end) {
+                    return;
+                }
+                try {
+                    func(begin, end);
+                }
+                catch (...) {
+                    errors[index] = std::current_exception();
+                }
+            };
+
+            {
+                std::lock_guard guard(mutex_);
+                task_ = &task;
+                pending_ = workers_.size();
+                ++generation_;
+            }
+            task_ready_.notify_all();
+            task(0);
+            {
+                std::unique_lock lock(mutex_);
+                task_done_.wait(lock, [this] {
+                    return pending_ == 0;
+                });
+                task_ = nullptr;
+            }
+
+            for (const auto& error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+
+    private:
+        void WorkerLoop(size_t index) {
+            uint64_t seen_generation = 0;
+            while (true) {
+                const std::function<void(size_t)>* task;
+                {
+                    std::unique_lock lock(mutex_);
+                    task_ready_.wait(lock, [this, seen_generation] {
+                        return stopping_ || generation_ != seen_generation;
+                    });
+                    if (stopping_) {
+                        return;
+                    }
+                    seen_generation = generation_;
+                    task = task_;
+                }
+                (*task)(index);
+                {
+                    std::lock_guard guard(mutex_);
+                    if (--pending_ == 0) {
+                        task_done_.notify_one();
+                    }
+                }
+            }
+        }
+
+        void Stop() {
+            {
+                std::lock_guard guard(mutex_);
+                stopping_ = true;
+            }
+            task_ready_.notify_all();
+            for (auto& worker : workers_) {
+                worker.join();
+            }
+            workers_.clear();
+        }
+
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable task_ready_;
+        std::condition_variable task_done_;
+        // Текущее задание; generation_ растёт с каждым новым заданием
+        const std::function<void(size_t)>* task_ = nullptr;
+        uint64_t generation_ = 0;
+        size_t pending_ = 0;
+        bool stopping_ = false;
+    };
+
+}  // namespace parallel
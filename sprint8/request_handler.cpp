@@ -3,25 +3,73 @@
 
 namespace request_handler {
 
-    RequestHandler::RequestHandler(const transport_catalogue::TransportCatalogue& db)
-            : db_(db) {}
+    RequestHandler::RequestHandler(const transport_catalogue::TransportCatalogue& db,
+                                   const transport_router::TransportRouter* router,
+                                   const catalogue_image::CatalogueImage* image)
+            : db_(db)
+            , router_(router)
+            , image_(image) {}
 
-    std::optional<std::vector<BusDetails>> RequestHandler::GetBusesByStop(const std::string& stop_name) const {
-        auto buses_opt = db_.GetBusesByStop(stop_name);
-        if (!buses_opt) {
+    std::optional<StopBuses> RequestHandler::GetBusesByStop(std::string_view stop_name) const {
+        if (image_) {
+            const auto stop_id = image_->FindStop(stop_name);
+            if (!stop_id) {
+                return std::nullopt;
+            }
+            return StopBuses(*image_, image_->GetStopBuses(*stop_id));
+        }
+
+        const auto bus_ids = db_.GetBusesByStop(stop_name);
+        if (!bus_ids) {
+            return std::nullopt;
+        }
+        return StopBuses(db_, *bus_ids);
+    }
+
+    std::optional<domain::BusInfo> RequestHandler::GetBusStat(std::string_view bus_name) const {
+        if (image_) {
+            const auto bus_id = image_->FindBus(bus_name);
+            if (!bus_id) {
+                return std::nullopt;
+            }
+            const auto& stat = image_->GetBusStat(*bus_id);
+            domain::BusInfo info;
+            info.count_stops = stat.stop_count;
+            info.unique_count_stops = stat.unique_stop_count;
+            info.len = stat.route_length;
+            info.curvature = stat.curvature;
+            return info;
+        }
+
+        const auto bus_id = db_.FindBusId(bus_name);
+        if (!bus_id) {
             return std::nullopt;
         }
+        return db_.GetBusInfo(*bus_id);
+    }
 
-        std::vector<BusDetails> bus_details;
-        for (const auto& bus_name : *buses_opt) {
-            bus_details.push_back({ bus_name });
+    std::vector<StopDistance> RequestHandler::GetStopsWithinRadius(geo::Coordinates center, double radius) const {
+        std::vector<StopDistance> result;
+        for (const auto& [id, distance] : db_.FindStopsWithinRadius(center, radius)) {
+            result.push_back({ db_.GetStop(id).name, distance });
         }
+        return result;
+    }
 
-        return bus_details;
+    std::optional<StopDistance> RequestHandler::GetNearestStop(geo::Coordinates center) const {
+        const auto nearest = db_.FindNearestStop(center);
+        if (!nearest) {
+            return std::nullopt;
+        }
+        return StopDistance{ db_.GetStop(nearest->index).name, nearest->distance };
     }
 
-    domain::BusInfo RequestHandler::GetBusInfo(const std::string& bus_name) const {
-        return db_.GetBusInfo(bus_name);
+    std::optional<transport_router::RouteResult> RequestHandler::BuildRoute(std::string_view from,
+                                                                           std::string_view to) const {
+        if (!router_) {
+            return std::nullopt;
+        }
+        return router_->BuildRoute(from, to);
     }
 
 } // namespace request_handler
\ No newline at end of file
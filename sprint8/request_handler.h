@@ -1,25 +1,107 @@
 #pragma once
+#include "catalogue_image.h"
 #include "transport_catalogue.h"
+#include "transport_router.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 
 namespace request_handler {
 
-    struct BusDetails {
-        std::string name;
+    // Имена маршрутов через остановку по возрастанию. Хранит отсортированный список идентификаторов
+    // из каталога или образа базы и берёт имена оттуда же; ничего не копирует и не выделяет
+    class StopBuses {
+    public:
+        class Iterator {
+        public:
+            Iterator(const StopBuses* owner, size_t index)
+                    : owner_(owner)
+                    , index_(index) {}
+
+            std::string_view operator*() const {
+                return (*owner_)[index_];
+            }
+
+            Iterator& operator++() {
+                ++index_;
+                return *this;
+            }
+
+            bool operator!=(const Iterator& other) const {
+                return index_ != other.index_;
+            }
+
+        private:
+            const StopBuses* owner_;
+            size_t index_;
+        };
+
+        StopBuses(const transport_catalogue::TransportCatalogue& db, array_view::ArrayView<domain::BusId> ids)
+                : db_(&db)
+                , ids_(ids) {}
+
+        StopBuses(const catalogue_image::CatalogueImage& image, array_view::ArrayView<domain::BusId> ids)
+                : image_(&image)
+                , ids_(ids) {}
+
+        size_t size() const {
+            return ids_.size();
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        std::string_view operator[](size_t index) const {
+            return image_ ? image_->GetBusName(ids_[index]) : db_->GetBus(ids_[index]).name;
+        }
+
+        Iterator begin() const {
+            return { this, 0 };
+        }
+
+        Iterator end() const {
+            return { this, size() };
+        }
+
+    private:
+        const transport_catalogue::TransportCatalogue* db_ = nullptr;
+        const catalogue_image::CatalogueImage* image_ = nullptr;
+        array_view::ArrayView<domain::BusId> ids_;
+    };
+
+    struct StopDistance {
+        std::string_view name;
+        double distance;
     };
 
     class RequestHandler {
     public:
-        RequestHandler(const transport_catalogue::TransportCatalogue& db);
+        // router может отсутствовать, если во входных данных нет routing_settings.
+        // Если задан image, запросы Stop и Bus обслуживаются прямо из образа базы, и db может быть пустым
+        RequestHandler(const transport_catalogue::TransportCatalogue& db,
+                       const transport_router::TransportRouter* router = nullptr,
+                       const catalogue_image::CatalogueImage* image = nullptr);
+
+        // nullopt, если остановка не найдена
+        std::optional<StopBuses> GetBusesByStop(std::string_view stop_name) const;
+
+        // nullopt, если маршрут не найден
+        std::optional<domain::BusInfo> GetBusStat(std::string_view bus_name) const;
+
+        // Остановки в радиусе radius метров, от ближней к дальней
+        std::vector<StopDistance> GetStopsWithinRadius(geo::Coordinates center, double radius) const;
 
-        std::optional<std::vector<BusDetails>> GetBusesByStop(const std::string& stop_name) const;
+        std::optional<StopDistance> GetNearestStop(geo::Coordinates center) const;
 
-        domain::BusInfo GetBusInfo(const std::string& bus_name) const;
+        // nullopt, если маршрута нет, одна из остановок неизвестна или маршрутизатор не задан
+        std::optional<transport_router::RouteResult> BuildRoute(std::string_view from, std::string_view to) const;
 
     private:
         const transport_catalogue::TransportCatalogue& db_;
+        const transport_router::TransportRouter* router_;
+        const catalogue_image::CatalogueImage* image_;
     };
 
 } // namespace request_handler
\ No newline at end of file
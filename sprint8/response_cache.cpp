@@ -0,0 +1,58 @@
+#include "response_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace response_cache {
+
+    size_t ResponseCache::KeyHasher::operator()(const Key& key) const {
+        const size_t seed = std::hash<std::string_view>{}(key.type);
+        return seed ^ (std::hash<std::string_view>{}(key.name) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    }
+
+    ResponseCache::ResponseCache(size_t capacity)
+            : capacity_(std::max<size_t>(capacity, 1)) {
+        index_.reserve(capacity_);
+    }
+
+    std::shared_ptr<const CachedResponse> ResponseCache::Find(std::string_view type, std::string_view name) {
+        const std::lock_guard lock(mutex_);
+        const auto it = index_.find({ type, name });
+        if (it == index_.end()) {
+            ++stats_.misses;
+            return nullptr;
+        }
+        ++stats_.hits;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->response;
+    }
+
+    void ResponseCache::Insert(std::string_view type, std::string_view name,
+                               std::shared_ptr<const CachedResponse> response) {
+        const std::lock_guard lock(mutex_);
+        if (index_.count({ type, name })) {
+            return;
+        }
+        if (entries_.size() == capacity_) {
+            const Entry& oldest = entries_.back();
+            index_.erase({ oldest.type, oldest.name });
+            entries_.pop_back();
+            ++stats_.evictions;
+        }
+        entries_.push_front({ std::string(type), std::string(name), std::move(response) });
+        const Entry& added = entries_.front();
+        index_.emplace(Key{ added.type, added.name }, entries_.begin());
+    }
+
+    void ResponseCache::Clear() {
+        const std::lock_guard lock(mutex_);
+        index_.clear();
+        entries_.clear();
+    }
+
+    CacheStats ResponseCache::GetStats() const {
+        const std::lock_guard lock(mutex_);
+        return stats_;
+    }
+
+}  // namespace response_cache
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace response_cache {
+
+    // Напечатанный ответ без значения request_id: текст до него и после него
+    struct CachedResponse {
+        std::string prefix;
+        std::string suffix;
+    };
+
+    struct CacheStats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+    };
+
+    // Ограниченный LRU-кэш напечатанных ответов по ключу (тип запроса, имя).
+    // Потокобезопасен: при параллельной обработке к нему обращаются несколько потоков.
+    // Ответ отдаётся через shared_ptr, поэтому его можно дописывать, даже если
+    // другой поток тем временем вытеснил запись
+    class ResponseCache {
+    public:
+        // capacity — максимальное число ответов, не меньше 1
+        explicit ResponseCache(size_t capacity);
+
+        // Найденная запись становится самой свежей; промах учитывается в статистике
+        std::shared_ptr<const CachedResponse> Find(std::string_view type, std::string_view name);
+
+        // Добавляет ответ, вытесняя самый давний при переполнении.
+        // Если другой поток успел добавить ответ с тем же ключом, остаётся прежний
+        void Insert(std::string_view type, std::string_view name, std::shared_ptr<const CachedResponse> response);
+
+        // Удаляет все ответы (например, после изменения данных); статистика сохраняется
+        void Clear();
+
+        CacheStats GetStats() const;
+
+    private:
+        struct Entry {
+            std::string type;
+            std::string name;
+            std::shared_ptr<const CachedResponse> response;
+        };
+
+        // Ключи-string_view смотрят в строки записи: узлы std::list не перемещаются
+        struct Key {
+            std::string_view type;
+            std::string_view name;
+
+            bool operator==(const Key& other) const {
+                return type == other.type && name == other.name;
+            }
+        };
+
+        struct KeyHasher {
+            size_t operator()(const Key& key) const;
+        };
+
+        size_t capacity_;
+        mutable std::mutex mutex_;
+        // От самой свежей записи к самой давней
+        std::list<Entry> entries_;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHasher> index_;
+        CacheStats stats_;
+    };
+
+}  // namespace response_cache
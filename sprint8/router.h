@@ -0,0 +1,142 @@
+#pragma once
+
+#include "graph.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Кратчайшие пути во взвешенном графе с неотрицательными весами.
+    // Для каждого источника дерево путей строится алгоритмом Дейкстры один раз
+    // и кэшируется, так что повторные запросы из той же вершины — только восстановление пути.
+    // Кэш не ограничен: дерево занимает O(V), и после запросов из всех вершин в памяти O(V²).
+    // Деревья можно построить заранее (Precompute). Все методы потокобезопасны
+    template <typename Weight>
+    class Router {
+    public:
+        struct RouteInfo {
+            Weight weight;
+            std::vector<EdgeId> edges;
+        };
+
+        explicit Router(const DirectedWeightedGraph<Weight>& graph);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+        // Строит деревья путей для источников sources в thread_count потоках (0 — по числу ядер)
+        void Precompute(const std::vector<VertexId>& sources, size_t thread_count) const;
+
+        // Сколько байт занимают уже построенные деревья путей
+        size_t GetCachedRoutesBytes() const;
+
+    private:
+        struct RouteInternalData {
+            Weight weight;
+            std::optional<EdgeId> prev_edge;
+        };
+
+        // Для каждой вершины — кратчайший путь из источника или nullopt, если она недостижима
+        using RoutesFromSource = std::vector<std::optional<RouteInternalData>>;
+
+        const RoutesFromSource& GetRoutesFrom(VertexId from) const;
+        RoutesFromSource ComputeRoutesFrom(VertexId from) const;
+
+        const DirectedWeightedGraph<Weight>& graph_;
+
+        // Индексируются вершиной-источником
+        mutable std::vector<std::once_flag> computed_;
+        mutable std::vector<std::unique_ptr<const RoutesFromSource>> routes_;
+        mutable std::atomic<size_t> computed_count_ = 0;
+    };
+
+    template <typename Weight>
+    Router<Weight>::Router(const DirectedWeightedGraph<Weight>& graph)
+            : graph_(graph)
+            , computed_(graph.GetVertexCount())
+            , routes_(graph.GetVertexCount()) {
+        if (!graph_.IsIncidenceBuilt()) {
+            throw std::logic_error("Graph incidence lists are not built");
+        }
+    }
+
+    template <typename Weight>
+    const typename Router<Weight>::RoutesFromSource& Router<Weight>::GetRoutesFrom(VertexId from) const {
+        std::call_once(computed_.at(from), [this, from] {
+            routes_[from] = std::make_unique<const RoutesFromSource>(ComputeRoutesFrom(from));
+            ++computed_count_;
+        });
+        return *routes_[from];
+    }
+
+    template <typename Weight>
+    typename Router<Weight>::RoutesFromSource Router<Weight>::ComputeRoutesFrom(VertexId from) const {
+        RoutesFromSource routes(graph_.GetVertexCount());
+        routes[from] = RouteInternalData{ Weight{}, std::nullopt };
+
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+        queue.push({ Weight{}, from });
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weight > routes[vertex]->weight) {
+                continue;
+            }
+            for (const EdgeId* it = graph_.IncidentEdgesBegin(vertex); it != graph_.IncidentEdgesEnd(vertex); ++it) {
+                const auto& edge = graph_.GetEdge(*it);
+                const Weight new_weight = weight + edge.weight;
+                auto& route = routes[edge.to];
+                if (!route || new_weight < route->weight) {
+                    route = RouteInternalData{ new_weight, *it };
+                    queue.push({ new_weight, edge.to });
+                }
+            }
+        }
+        return routes;
+    }
+
+    template <typename Weight>
+    std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        const auto& routes = GetRoutesFrom(from);
+        const auto& route = routes.at(to);
+        if (!route) {
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> edges;
+        for (std::optional<EdgeId> edge_id = route->prev_edge; edge_id;
+             edge_id = routes[graph_.GetEdge(*edge_id).from]->prev_edge) {
+            edges.push_back(*edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+        return RouteInfo{ route->weight, std::move(edges) };
+    }
+
+    template <typename Weight>
+    void Router<Weight>::Precompute(const std::vector<VertexId>& sources, size_t thread_count) const {
+        parallel::ForEachChunk(sources.size(), thread_count, [this, &sources](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                GetRoutesFrom(sources[i]);
+            }
+        });
+    }
+
+    template <typename Weight>
+    size_t Router<Weight>::GetCachedRoutesBytes() const {
+        // Размер каждого дерева равен числу вершин, поэтому считать по самим деревьям не нужно
+        const size_t tree_bytes = sizeof(RoutesFromSource)
+                                  + graph_.GetVertexCount() * sizeof(typename RoutesFromSource::value_type);
+        return computed_count_ * tree_bytes;
+    }
+
+}  // namespace graph
@@ -0,0 +1,247 @@
+#include "serialization.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace serialization {
+
+    using namespace std::literals;
+
+    namespace {
+
+        // Настройки — небольшой последовательный блок внутри образа каталога
+        constexpr uint32_t SETTINGS_VERSION = 1;
+
+        class Writer {
+        public:
+            explicit Writer(std::string& output)
+                    : output_(output) {}
+
+            template <typename Value>
+            void Write(Value value) {
+                static_assert(std::is_arithmetic_v<Value>);
+                output_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+            }
+
+            void WriteSize(size_t size) {
+                Write(static_cast<uint32_t>(size));
+            }
+
+            void WriteString(std::string_view text) {
+                WriteSize(text.size());
+                output_.append(text);
+            }
+
+            void WritePoint(svg::Point point) {
+                Write(point.x);
+                Write(point.y);
+            }
+
+            void WriteColor(const svg::Color& color) {
+                Write(static_cast<uint8_t>(color.index()));
+                std::visit([this](const auto& value) {
+                    using T = std::decay_t<decltype(value)>;
+                    if constexpr (std::is_same_v<T, std::string>) {
+                        WriteString(value);
+                    }
+                    else if constexpr (std::is_same_v<T, svg::Rgb>) {
+                        Write(value.red);
+                        Write(value.green);
+                        Write(value.blue);
+                    }
+                    else if constexpr (std::is_same_v<T, svg::Rgba>) {
+                        Write(value.red);
+                        Write(value.green);
+                        Write(value.blue);
+                        Write(value.opacity);
+                    }
+                }, color);
+            }
+
+        private:
+            std::string& output_;
+        };
+
+        class Reader {
+        public:
+            explicit Reader(std::string_view input)
+                    : input_(input) {}
+
+            template <typename Value>
+            Value Read() {
+                static_assert(std::is_arithmetic_v<Value>);
+                Value value{};
+                ReadBytes(reinterpret_cast<char*>(&value), sizeof(value));
+                return value;
+            }
+
+            size_t ReadSize() {
+                return Read<uint32_t>();
+            }
+
+            std::string ReadString() {
+                std::string text(ReadSize(), '\0');
+                ReadBytes(text.data(), text.size());
+                return text;
+            }
+
+            svg::Point ReadPoint() {
+                const double x = Read<double>();
+                const double y = Read<double>();
+                return { x, y };
+            }
+
+            svg::Color ReadColor() {
+                switch (Read<uint8_t>()) {
+                    case 0:
+                        return std::monostate{};
+                    case 1:
+                        return ReadString();
+                    case 2: {
+                        const auto red = Read<uint8_t>();
+                        const auto green = Read<uint8_t>();
+                        const auto blue = Read<uint8_t>();
+                        return svg::Rgb{ red, green, blue };
+                    }
+                    case 3: {
+                        const auto red = Read<uint8_t>();
+                        const auto green = Read<uint8_t>();
+                        const auto blue = Read<uint8_t>();
+                        const auto opacity = Read<double>();
+                        return svg::Rgba{ red, green, blue, opacity };
+                    }
+                    default:
+                        throw std::runtime_error("Snapshot is corrupted: unknown color type");
+                }
+            }
+
+        private:
+            void ReadBytes(char* data, size_t size) {
+                if (size > input_.size()) {
+                    throw std::runtime_error("Snapshot is truncated");
+                }
+                std::memcpy(data, input_.data(), size);
+                input_.remove_prefix(size);
+            }
+
+            std::string_view input_;
+        };
+
+        void SaveRenderSettings(const map_renderer::RenderSettings& settings, Writer& writer) {
+            writer.Write(settings.width);
+            writer.Write(settings.height);
+            writer.Write(settings.padding);
+            writer.Write(settings.line_width);
+            writer.Write(settings.stop_radius);
+            writer.WritePoint(settings.bus_label_offset);
+            writer.WritePoint(settings.stop_label_offset);
+            writer.Write(settings.bus_label_font_size);
+            writer.Write(settings.stop_label_font_size);
+            writer.WriteColor(settings.underlayer_color);
+            writer.Write(settings.underlayer_width);
+            writer.WriteSize(settings.color_palette.size());
+            for (const auto& color : settings.color_palette) {
+                writer.WriteColor(color);
+            }
+        }
+
+        map_renderer::RenderSettings LoadRenderSettings(Reader& reader) {
+            map_renderer::RenderSettings settings;
+            settings.width = reader.Read<double>();
+            settings.height = reader.Read<double>();
+            settings.padding = reader.Read<double>();
+            settings.line_width = reader.Read<double>();
+            settings.stop_radius = reader.Read<double>();
+            settings.bus_label_offset = reader.ReadPoint();
+            settings.stop_label_offset = reader.ReadPoint();
+            settings.bus_label_font_size = reader.Read<int>();
+            settings.stop_label_font_size = reader.Read<int>();
+            settings.underlayer_color = reader.ReadColor();
+            settings.underlayer_width = reader.Read<double>();
+            const size_t palette_size = reader.ReadSize();
+            for (size_t i = 0; i < palette_size; ++i) {
+                settings.color_palette.push_back(reader.ReadColor());
+            }
+            return settings;
+        }
+
+    }  // namespace
+
+    void SaveSnapshot(const transport_catalogue::TransportCatalogue& tc, const BaseSettings& settings,
+                      std::ostream& output) {
+        std::string settings_data;
+        Writer writer(settings_data);
+        writer.Write(SETTINGS_VERSION);
+        SaveRenderSettings(settings.render_settings, writer);
+        writer.Write(static_cast<uint8_t>(settings.routing_settings.has_value()));
+        if (settings.routing_settings) {
+            writer.Write(settings.routing_settings->bus_wait_time);
+            writer.Write(settings.routing_settings->bus_velocity);
+        }
+
+        const std::string image = catalogue_image::BuildImage(tc, settings_data);
+        output.write(image.data(), static_cast<std::streamsize>(image.size()));
+        if (!output) {
+            throw std::runtime_error("Failed to write snapshot");
+        }
+    }
+
+    BaseSettings LoadSettings(const catalogue_image::CatalogueImage& image) {
+        Reader reader(image.GetExtra());
+        if (reader.Read<uint32_t>() != SETTINGS_VERSION) {
+            throw std::runtime_error("Unsupported snapshot settings version");
+        }
+        BaseSettings settings;
+        settings.render_settings = LoadRenderSettings(reader);
+        if (reader.Read<uint8_t>() != 0) {
+            transport_router::RoutingSettings routing_settings;
+            routing_settings.bus_wait_time = reader.Read<int>();
+            routing_settings.bus_velocity = reader.Read<double>();
+            settings.routing_settings = routing_settings;
+        }
+        return settings;
+    }
+
+    void LoadCatalogue(const catalogue_image::CatalogueImage& image, transport_catalogue::TransportCatalogue& tc,
+                       size_t thread_count) {
+        const size_t stop_count = image.GetStopCount();
+        for (domain::StopId id = 0; id < stop_count; ++id) {
+            tc.AddStop({ image.GetStopName(id), image.GetStopCoordinates(id) });
+        }
+
+        for (domain::BusId id = 0; id < image.GetBusCount(); ++id) {
+            const auto stops = image.GetBusStops(id);
+            for (const domain::StopId stop_id : stops) {
+                if (stop_id >= stop_count) {
+                    throw std::runtime_error("Snapshot is corrupted: unknown stop id");
+                }
+            }
+            tc.AddBus(image.GetBusName(id), std::vector<domain::StopId>(stops.begin(), stops.end()),
+                      image.IsBusCircular(id));
+        }
+
+        const auto offsets = image.GetDistanceOffsets();
+        const auto targets = image.GetDistanceTargets();
+        const auto values = image.GetDistanceValues();
+        for (domain::StopId from = 0; from < stop_count; ++from) {
+            if (offsets[from] > offsets[from + 1] || offsets[from + 1] > targets.size()) {
+                throw std::runtime_error("Snapshot is corrupted: bad distance index");
+            }
+            for (uint32_t i = offsets[from]; i < offsets[from + 1]; ++i) {
+                if (targets[i] >= stop_count) {
+                    throw std::runtime_error("Snapshot is corrupted: unknown stop id");
+                }
+                tc.SetDistance(from, targets[i], values[i]);
+            }
+        }
+
+        tc.Finalize(thread_count);
+    }
+
+}  // namespace serialization
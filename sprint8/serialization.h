@@ -0,0 +1,31 @@
+#pragma once
+
+#include "catalogue_image.h"
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+#include <optional>
+#include <ostream>
+
+namespace serialization {
+
+    // Всё, что make_base сохраняет помимо самого каталога
+    struct BaseSettings {
+        map_renderer::RenderSettings render_settings;
+        std::optional<transport_router::RoutingSettings> routing_settings;
+    };
+
+    // Двоичный снимок — образ каталога (см. catalogue_image.h), в блоке extra которого лежат настройки.
+    // Числа пишутся в порядке байтов текущей машины, снимок переносим только между одинаковыми платформами
+    void SaveSnapshot(const transport_catalogue::TransportCatalogue& tc, const BaseSettings& settings,
+                      std::ostream& output);
+
+    BaseSettings LoadSettings(const catalogue_image::CatalogueImage& image);
+
+    // Заполняет пустой каталог из образа и финализирует его в thread_count потоках.
+    // Нужен только запросам, которые образ не обслуживает сам (карта, маршруты, геопоиск).
+    // Повреждённый образ — std::runtime_error
+    void LoadCatalogue(const catalogue_image::CatalogueImage& image, transport_catalogue::TransportCatalogue& tc,
+                       size_t thread_count = 1);
+
+}  // namespace serialization
@@ -1,9 +1,11 @@
 #include "svg.h"
+#include "number_format.h"
 #include <iomanip>
 
 namespace svg {
 
     using namespace std::literals;
+    using number_format::Number;
 
     std::ostream& operator<<(std::ostream& out, const StrokeLineCap& line_cap) {
         switch (line_cap) {
@@ -59,7 +61,7 @@ namespace svg {
                 out << "rgba(" << static_cast<int>(value.red) << ","
                     << static_cast<int>(value.green) << ","
                     << static_cast<int>(value.blue) << ","
-                    << value.opacity << ")";
+                    << Number{ value.opacity } << ")";
             }
         }, color);
         return out;
@@ -83,8 +85,8 @@ namespace svg {
 
     void Circle::RenderObject(const RenderContext& context) const {
         auto& out = context.out;
-        out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" ";
-        out << "r=\""sv << radius_ << "\"";
+        out << "<circle cx=\""sv << Number{ center_.x } << "\" cy=\""sv << Number{ center_.y } << "\" ";
+        out << "r=\""sv << Number{ radius_ } << "\"";
         RenderAttrs(out);
         out << "/>"sv;
     }
@@ -103,7 +105,7 @@ namespace svg {
                 out << " "sv;
             }
             first = false;
-            out << point.x << ","sv << point.y;
+            out << Number{ point.x } << ","sv << Number{ point.y };
         }
         out << "\"";
         RenderAttrs(out);
@@ -142,8 +144,8 @@ namespace svg {
 
     void Text::RenderObject(const RenderContext& context) const {
         auto& out = context.out;
-        out << "<text x=\""sv << position_.x << "\" y=\""sv << position_.y << "\" ";
-        out << "dx=\""sv << offset_.x << "\" dy=\""sv << offset_.y << "\" ";
+        out << "<text x=\""sv << Number{ position_.x } << "\" y=\""sv << Number{ position_.y } << "\" ";
+        out << "dx=\""sv << Number{ offset_.x } << "\" dy=\""sv << Number{ offset_.y } << "\" ";
         out << "font-size=\""sv << font_size_ << "\"";
         if (!font_family_.empty()) {
             out << " font-family=\""sv << font_family_ << "\"";
@@ -171,6 +173,15 @@ namespace svg {
         out << "</svg>"sv;
     }
 
+    void StreamWriter::Begin() {
+        context_.out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
+        context_.out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
+    }
+
+    void StreamWriter::End() {
+        context_.out << "</svg>"sv;
+    }
+
     std::string EscapeText(const std::string& data) {
         std::string escaped;
         for (char c : data) {
@@ -6,6 +6,7 @@
 #include <string>
 #include <variant>
 #include <vector>
+#include "number_format.h"
 
 namespace svg {
 
@@ -16,6 +17,10 @@ namespace svg {
 
         Rgb() = default;
         Rgb(uint8_t r, uint8_t g, uint8_t b) : red(r), green(g), blue(b) {}
+
+        bool operator==(const Rgb& other) const {
+            return red == other.red && green == other.green && blue == other.blue;
+        }
     };
 
     struct Rgba {
@@ -26,6 +31,10 @@ namespace svg {
 
         Rgba() = default;
         Rgba(uint8_t r, uint8_t g, uint8_t b, double o) : red(r), green(g), blue(b), opacity(o) {}
+
+        bool operator==(const Rgba& other) const {
+            return red == other.red && green == other.green && blue == other.blue && opacity == other.opacity;
+        }
     };
 
     using Color = std::variant<std::monostate, std::string, Rgb, Rgba>;
@@ -55,6 +64,10 @@ namespace svg {
         Point(double x, double y) : x(x), y(y) {}
         double x = 0;
         double y = 0;
+
+        bool operator==(const Point& other) const {
+            return x == other.x && y == other.y;
+        }
     };
 
     struct RenderContext {
@@ -126,7 +139,7 @@ namespace svg {
             if (!std::holds_alternative<std::monostate>(stroke_color_)) {
                 out << " stroke=\"" << stroke_color_ << "\"";
                 if (stroke_width_ != 1.0) {
-                    out << " stroke-width=\"" << stroke_width_ << "\"";
+                    out << " stroke-width=\"" << number_format::Number{ stroke_width_ } << "\"";
                 }
                 if (stroke_linecap_ != StrokeLineCap::BUTT) {
                     out << " stroke-linecap=\"" << stroke_linecap_ << "\"";
@@ -156,6 +169,8 @@ namespace svg {
         Circle& SetRadius(double radius);
 
     private:
+        friend class StreamWriter;
+
         void RenderObject(const RenderContext& context) const override;
 
         Point center_;
@@ -167,6 +182,8 @@ namespace svg {
         Polyline& AddPoint(Point point);
 
     private:
+        friend class StreamWriter;
+
         void RenderObject(const RenderContext& context) const override;
 
         std::vector<Point> points_;
@@ -182,6 +199,8 @@ namespace svg {
         Text& SetData(std::string data);
 
     private:
+        friend class StreamWriter;
+
         void RenderObject(const RenderContext& context) const override;
 
         Point position_ = { 0, 0 };
@@ -214,6 +233,29 @@ namespace svg {
         std::vector<std::unique_ptr<Object>> objects_;
     };
 
+    // Пишет SVG сразу в поток по мере добавления фигур, не храня их.
+    // Begin выводит заголовок документа, End — закрывающий тег; без них выводится
+    // фрагмент из одних фигур с тем же отступом, что внутри документа
+    class StreamWriter {
+    public:
+        explicit StreamWriter(std::ostream& out)
+                : context_(out, 2, 2) {}
+
+        void Begin();
+        void End();
+
+        template <typename Obj>
+        StreamWriter& Add(const Obj& obj) {
+            context_.RenderIndent();
+            obj.RenderObject(context_);
+            context_.out.put('\n');
+            return *this;
+        }
+
+    private:
+        RenderContext context_;
+    };
+
     class Drawable {
     public:
         virtual void Draw(ObjectContainer& container) const = 0;
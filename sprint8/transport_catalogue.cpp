@@ -1,79 +1,300 @@
 #include "transport_catalogue.h"
 #include "geo.h"
+#include "parallel.h"
 #include <algorithm>
-#include <unordered_set>
+#include <cmath>
 #include <vector>
 #include <stdexcept>
 #include <optional>
 
 namespace transport_catalogue {
 
+    namespace {
+
+        // Узел хеш-таблицы в libstdc++ хранит указатель на следующий узел, значение и хеш
+        template <typename Map>
+        size_t EstimateHashMapBytes(const Map& map) {
+            return map.bucket_count() * sizeof(void*)
+                   + map.size() * (sizeof(void*) + sizeof(typename Map::value_type) + sizeof(size_t));
+        }
+
+    }  // namespace
+
 // Добавление новой остановки
     void TransportCatalogue::AddStop(const domain::Stop& stop) {
-        stops_.emplace(stop.name, stop);
-        stop_string_views_.push_back(stops_.at(stop.name).name);
+        if (stop_ids_.count(stop.name)) {
+            return;
+        }
+        const auto id = static_cast<domain::StopId>(stops_.size());
+        const auto& added_stop = stops_.emplace_back(domain::Stop{ names_.Add(stop.name), stop.coordinates });
+        stop_ids_.emplace(added_stop.name, id);
+        ++version_;
+        finalized_ = false;
     }
 
 // Добавление нового маршрута
-    void TransportCatalogue::AddBus(const domain::Bus& bus) {
-        auto& added_bus = buses_.emplace(bus.name, domain::Bus{ bus.name, {}, bus.is_circular }).first->second;
+    void TransportCatalogue::AddBus(const std::string_view& name, const std::vector<std::string_view>& stops, bool is_circular) {
+        if (bus_ids_.count(name)) {
+            return;
+        }
+        std::vector<domain::StopId> stop_ids;
+        stop_ids.reserve(stops.size());
+        for (const auto& stop_name : stops) {
+            stop_ids.push_back(stop_ids_.at(stop_name));
+        }
+        AddBus(name, std::move(stop_ids), is_circular);
+    }
 
-        for (const auto& stop_name : bus.stops) {
-            const auto& stop_ref = stops_.at(std::string(stop_name));
-            added_bus.stops.push_back(stop_ref.name);
-            buses_by_stop_[stop_ref.name].insert(added_bus.name);
+    void TransportCatalogue::AddBus(const std::string_view& name, std::vector<domain::StopId> stops, bool is_circular) {
+        if (bus_ids_.count(name)) {
+            return;
         }
+        const auto id = static_cast<domain::BusId>(buses_.size());
+        for (const domain::StopId stop_id : stops) {
+            if (stop_id >= stops_.size()) {
+                throw std::out_of_range("Stop id is out of range");
+            }
+        }
+        auto& added_bus = buses_.emplace_back(domain::Bus{ names_.Add(name), std::move(stops), is_circular });
+        bus_ids_.emplace(added_bus.name, id);
+        ++version_;
+        finalized_ = false;
     }
 
     void TransportCatalogue::SetDistance(const std::string_view& from, const std::string_view& to, int distance) {
-        const domain::Stop* from_stop = FindStop(from);
-        const domain::Stop* to_stop = FindStop(to);
-        if (from_stop && to_stop) {
-            distances_[{from_stop, to_stop}] = distance;
+        const auto from_id = FindStopId(from);
+        const auto to_id = FindStopId(to);
+        if (from_id && to_id) {
+            SetDistance(*from_id, *to_id, distance);
+        }
+    }
+
+    void TransportCatalogue::SetDistance(domain::StopId from, domain::StopId to, int distance) {
+        if (from >= stops_.size() || to >= stops_.size()) {
+            throw std::out_of_range("Stop id is out of range");
+        }
+        distances_.push_back({ from, to, distance });
+        ++version_;
+        finalized_ = false;
+    }
+
+    void TransportCatalogue::Finalize(size_t thread_count) {
+        BuildDistanceIndex();
+        BuildStopIndex();
+        BuildStopBusIndex();
+        ComputeMaxSegmentSpan();
+        finalized_ = true;
+        BuildBusInfos(thread_count);
+    }
+
+    void TransportCatalogue::CheckFinalized() const {
+        if (!finalized_) {
+            throw std::logic_error("TransportCatalogue is not finalized");
+        }
+    }
+
+    // distances_ сортируется на месте и после построения CSR освобождается. При повторном Finalize
+    // явно заданные расстояния восстанавливаются из CSR и ставятся перед добавленными позже
+    void TransportCatalogue::BuildDistanceIndex() {
+        const auto by_direction = [](const domain::RoadDistance& lhs, const domain::RoadDistance& rhs) {
+            return std::pair(lhs.from, lhs.to) < std::pair(rhs.from, rhs.to);
+        };
+
+        std::vector<domain::RoadDistance> restored;
+        for (domain::StopId from = 0; from + 1 < distance_offsets_.size(); ++from) {
+            for (uint32_t i = distance_offsets_[from]; i < distance_offsets_[from + 1]; ++i) {
+                if (!distance_derived_[i]) {
+                    restored.push_back({ from, distance_targets_[i], distance_values_[i] });
+                }
+            }
+        }
+        distances_.insert(distances_.begin(), restored.begin(), restored.end());
+
+        // Явно заданные расстояния: при повторной установке побеждает последнее значение
+        std::stable_sort(distances_.begin(), distances_.end(), by_direction);
+        // unique по обратному диапазону оставляет последний элемент каждой группы
+        const auto same_direction = [](const domain::RoadDistance& lhs, const domain::RoadDistance& rhs) {
+            return lhs.from == rhs.from && lhs.to == rhs.to;
+        };
+        const auto first_kept = std::unique(distances_.rbegin(), distances_.rend(), same_direction).base();
+        distances_.erase(distances_.begin(), first_kept);
+
+        // Обратное направление берётся из прямого, если для него нет своего значения.
+        // Достроенные записи дописываются в конец и сортируются отдельно
+        const size_t explicit_count = distances_.size();
+        for (size_t i = 0; i < explicit_count; ++i) {
+            const domain::RoadDistance reverse{ distances_[i].to, distances_[i].from, distances_[i].distance };
+            if (!std::binary_search(distances_.begin(), distances_.begin() + explicit_count, reverse, by_direction)) {
+                distances_.push_back(reverse);
+            }
+        }
+        const auto derived_begin = distances_.begin() + explicit_count;
+        std::sort(derived_begin, distances_.end(), by_direction);
+
+        distance_offsets_.assign(stops_.size() + 1, 0);
+        distance_targets_.clear();
+        distance_values_.clear();
+        distance_derived_.clear();
+        distance_targets_.reserve(distances_.size());
+        distance_values_.reserve(distances_.size());
+        distance_derived_.reserve(distances_.size());
+        const auto add_entry = [this](const domain::RoadDistance& entry, bool derived) {
+            ++distance_offsets_[entry.from + 1];
+            distance_targets_.push_back(entry.to);
+            distance_values_.push_back(entry.distance);
+            distance_derived_.push_back(derived);
+        };
+        // Слияние двух отсортированных диапазонов; направления в них не пересекаются
+        auto explicit_it = distances_.begin();
+        auto derived_it = derived_begin;
+        while (explicit_it != derived_begin || derived_it != distances_.end()) {
+            if (derived_it == distances_.end()
+                || (explicit_it != derived_begin && by_direction(*explicit_it, *derived_it))) {
+                add_entry(*explicit_it++, false);
+            }
+            else {
+                add_entry(*derived_it++, true);
+            }
+        }
+        for (size_t i = 1; i < distance_offsets_.size(); ++i) {
+            distance_offsets_[i] += distance_offsets_[i - 1];
+        }
+
+        distances_.clear();
+        distances_.shrink_to_fit();
+    }
+
+    void TransportCatalogue::BuildStopIndex() {
+        std::vector<geo::Coordinates> coordinates;
+        coordinates.reserve(stops_.size());
+        for (const auto& stop : stops_) {
+            coordinates.push_back(stop.coordinates);
+        }
+        stop_index_ = geo::GridIndex(std::move(coordinates));
+    }
+
+    // Пары (остановка, маршрут) сортируются и склеиваются без повторов: маршрут может
+    // проходить остановку несколько раз, а в списке остановки он должен быть один раз.
+    // Имена маршрутов уникальны, поэтому порядок по имени однозначен
+    void TransportCatalogue::BuildStopBusIndex() {
+        std::vector<std::pair<domain::StopId, domain::BusId>> pairs;
+        for (domain::BusId bus_id = 0; bus_id < buses_.size(); ++bus_id) {
+            for (const domain::StopId stop_id : buses_[bus_id].stops) {
+                pairs.emplace_back(stop_id, bus_id);
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+        std::sort(pairs.begin(), pairs.end(), [this](const auto& lhs, const auto& rhs) {
+            return std::pair(lhs.first, buses_[lhs.second].name) < std::pair(rhs.first, buses_[rhs.second].name);
+        });
+
+        stop_bus_offsets_.assign(stops_.size() + 1, 0);
+        stop_bus_ids_.clear();
+        stop_bus_ids_.reserve(pairs.size());
+        for (const auto& [stop_id, bus_id] : pairs) {
+            ++stop_bus_offsets_[stop_id + 1];
+            stop_bus_ids_.push_back(bus_id);
+        }
+        stop_bus_ids_.shrink_to_fit();
+        for (size_t i = 1; i < stop_bus_offsets_.size(); ++i) {
+            stop_bus_offsets_[i] += stop_bus_offsets_[i - 1];
+        }
+    }
+
+    void TransportCatalogue::ComputeMaxSegmentSpan() {
+        max_segment_span_ = { 0, 0 };
+        for (const auto& bus : buses_) {
+            for (size_t i = 0; i + 1 < bus.stops.size(); ++i) {
+                const auto& from = stops_[bus.stops[i]].coordinates;
+                const auto& to = stops_[bus.stops[i + 1]].coordinates;
+                max_segment_span_.lat = std::max(max_segment_span_.lat, std::abs(from.lat - to.lat));
+                max_segment_span_.lng = std::max(max_segment_span_.lng, std::abs(from.lng - to.lng));
+            }
         }
     }
 
-    const std::vector<std::string_view>& TransportCatalogue::GetBusStops(const std::string_view& bus_name) const {
-        auto bus_it = buses_.find(std::string(bus_name));
-        if (bus_it != buses_.end()) {
-            return bus_it->second.stops;
+    geo::Coordinates TransportCatalogue::GetMaxSegmentSpan() const {
+        CheckFinalized();
+        return max_segment_span_;
+    }
+
+    std::vector<domain::StopId> TransportCatalogue::FindStopsInBox(const geo::BoundingBox& box) const {
+        CheckFinalized();
+        return stop_index_.FindInBox(box);
+    }
+
+    std::vector<geo::GridIndex::Neighbor> TransportCatalogue::FindStopsWithinRadius(geo::Coordinates center,
+                                                                                    double radius) const {
+        CheckFinalized();
+        return stop_index_.FindWithinRadius(center, radius);
+    }
+
+    std::optional<geo::GridIndex::Neighbor> TransportCatalogue::FindNearestStop(geo::Coordinates center) const {
+        CheckFinalized();
+        return stop_index_.FindNearest(center);
+    }
+
+    const std::vector<domain::StopId>& TransportCatalogue::GetBusStops(const std::string_view& bus_name) const {
+        if (const domain::Bus* bus = FindBus(bus_name)) {
+            return bus->stops;
         }
         else {
-            static const std::vector<std::string_view> empty_result;
+            static const std::vector<domain::StopId> empty_result;
             return empty_result;
         }
     }
 
 // Получение информации о маршруте
-    domain::BusInfo TransportCatalogue::GetBusInfo(const std::string_view& bus_name) const {
-        auto bus_it = buses_.find(std::string(bus_name));
-        if (bus_it == buses_.end()) {
+    const domain::BusInfo& TransportCatalogue::GetBusInfo(const std::string_view& bus_name) const {
+        const auto bus_id = FindBusId(bus_name);
+        if (!bus_id) {
             throw std::out_of_range("Bus not found");
         }
+        return GetBusInfo(*bus_id);
+    }
+
+    const domain::BusInfo& TransportCatalogue::GetBusInfo(domain::BusId id) const {
+        CheckFinalized();
+        return bus_infos_.at(id);
+    }
+
+    void TransportCatalogue::BuildBusInfos(size_t thread_count) {
+        // Маршруты независимы: каждый поток пишет только в свою часть bus_infos_
+        bus_infos_.assign(buses_.size(), {});
+        parallel::ForEachChunk(buses_.size(), thread_count, [this](size_t begin, size_t end) {
+            for (size_t id = begin; id < end; ++id) {
+                bus_infos_[id] = ComputeBusInfo(buses_[id]);
+            }
+        });
+    }
+
+    domain::BusInfo TransportCatalogue::ComputeBusInfo(const domain::Bus& bus) const {
+        std::vector<domain::StopId> unique_stops = bus.stops;
+        std::sort(unique_stops.begin(), unique_stops.end());
+        unique_stops.erase(std::unique(unique_stops.begin(), unique_stops.end()), unique_stops.end());
 
-        const auto& bus = bus_it->second;
-        std::unordered_set<std::string_view> unique_stops(bus.stops.begin(), bus.stops.end());
         double total_length = 0;
         double geo_length = 0;
 
+        // Для некольцевого маршрута обратный путь считается в том же проходе
         for (size_t i = 0; i + 1 < bus.stops.size(); ++i) {
-            const auto& from = stops_.at(std::string(bus.stops[i]));
-            const auto& to = stops_.at(std::string(bus.stops[i + 1]));
-            total_length += GetDistance(bus.stops[i], bus.stops[i + 1]);
-            geo_length += geo::ComputeDistance(from.coordinates, to.coordinates);
+            const domain::StopId from = bus.stops[i];
+            const domain::StopId to = bus.stops[i + 1];
+            total_length += GetDistance(from, to);
+            if (!bus.is_circular) {
+                total_length += GetDistance(to, from);
+            }
+            geo_length += geo::ComputeDistance(stops_[from].coordinates, stops_[to].coordinates);
         }
 
         if (!bus.is_circular) {
-            for (size_t i = bus.stops.size() - 1; i > 0; --i) {
-                total_length += GetDistance(bus.stops[i], bus.stops[i - 1]);
-            }
             geo_length *= 2;
         }
 
         double curvature = geo_length > 0 ? total_length / geo_length : 0;
 
         domain::BusInfo bus_info;
-        bus_info.name = bus.name;
         bus_info.count_stops = bus.is_circular ? bus.stops.size() : bus.stops.size() * 2 - 1;
         bus_info.unique_count_stops = unique_stops.size();
         bus_info.len = total_length;
@@ -83,72 +304,130 @@ namespace transport_catalogue {
     }
 
 // Получение списка автобусов, проходящих через остановку
-    std::optional<std::vector<std::string>> TransportCatalogue::GetBusesByStop(const std::string_view& stop_name) const {
-        auto stop_it = stops_.find(std::string(stop_name));
-        if (stop_it == stops_.end()) {
+    std::optional<array_view::ArrayView<domain::BusId>> TransportCatalogue::GetBusesByStop(
+            const std::string_view& stop_name) const {
+        const auto stop_id = FindStopId(stop_name);
+        if (!stop_id) {
             return std::nullopt;
         }
+        return GetBusIdsByStop(*stop_id);
+    }
 
-        auto buses_it = buses_by_stop_.find(stop_name);
-        if (buses_it == buses_by_stop_.end()) {
-            return std::vector<std::string>{};
+    array_view::ArrayView<domain::BusId> TransportCatalogue::GetBusIdsByStop(domain::StopId id) const {
+        CheckFinalized();
+        if (id >= stops_.size()) {
+            throw std::out_of_range("Stop id is out of range");
         }
+        const uint32_t begin = stop_bus_offsets_[id];
+        return { stop_bus_ids_.data() + begin, stop_bus_offsets_[id + 1] - begin };
+    }
 
-        std::vector<std::string> buses(buses_it->second.begin(), buses_it->second.end());
-        std::sort(buses.begin(), buses.end());
-        return buses;
+    bool TransportCatalogue::HasBuses(domain::StopId id) const {
+        return !GetBusIdsByStop(id).empty();
     }
+
 // Поиск маршрута по имени
     const domain::Stop* TransportCatalogue::FindStop(const std::string_view& name) const {
-        auto it = stops_.find(std::string(name));
-        if (it == stops_.end()) {
-            return nullptr;
-        }
-        return &it->second;
+        const auto id = FindStopId(name);
+        return id ? &stops_[*id] : nullptr;
     }
 
     const domain::Bus* TransportCatalogue::FindBus(const std::string_view& name) const {
-        auto it = buses_.find(std::string(name));
-        if (it == buses_.end()) {
-            return nullptr;
-        }
-        return &it->second;
+        const auto id = FindBusId(name);
+        return id ? &buses_[*id] : nullptr;
     }
 
-    int TransportCatalogue::GetDistance(const std::string_view& from, const std::string_view& to) const {
-        const domain::Stop* from_stop = FindStop(from);
-        const domain::Stop* to_stop = FindStop(to);
+    std::optional<domain::StopId> TransportCatalogue::FindStopId(const std::string_view& name) const {
+        auto it = stop_ids_.find(name);
+        if (it == stop_ids_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
 
-        auto it = distances_.find({ from_stop, to_stop });
-        if (it != distances_.end()) {
-            return it->second;
+    std::optional<domain::BusId> TransportCatalogue::FindBusId(const std::string_view& name) const {
+        auto it = bus_ids_.find(name);
+        if (it == bus_ids_.end()) {
+            return std::nullopt;
         }
+        return it->second;
+    }
+
+    const domain::Stop& TransportCatalogue::GetStop(domain::StopId id) const {
+        return stops_.at(id);
+    }
 
-        it = distances_.find({ to_stop, from_stop });
-        if (it != distances_.end()) {
-            return it->second;
+    const domain::Bus& TransportCatalogue::GetBus(domain::BusId id) const {
+        return buses_.at(id);
+    }
+
+    int TransportCatalogue::GetDistance(const std::string_view& from, const std::string_view& to) const {
+        const auto from_id = FindStopId(from);
+        const auto to_id = FindStopId(to);
+        if (!from_id || !to_id) {
+            return 0;
         }
+        return GetDistance(*from_id, *to_id);
+    }
 
+    int TransportCatalogue::GetDistance(domain::StopId from, domain::StopId to) const {
+        CheckFinalized();
+        const auto row_begin = distance_targets_.begin() + distance_offsets_[from];
+        const auto row_end = distance_targets_.begin() + distance_offsets_[from + 1];
+        const auto it = std::lower_bound(row_begin, row_end, to);
+        if (it != row_end && *it == to) {
+            return distance_values_[it - distance_targets_.begin()];
+        }
         return 0;
     }
 
-    size_t TransportCatalogue::PairHash::operator()(const std::pair<const domain::Stop*, const domain::Stop*>& pair) const {
-        return std::hash<const void*>()(pair.first) ^ std::hash<const void*>()(pair.second);
+    std::vector<domain::RoadDistance> TransportCatalogue::GetDistances() const {
+        CheckFinalized();
+        std::vector<domain::RoadDistance> distances;
+        distances.reserve(distance_targets_.size());
+        for (domain::StopId from = 0; from < stops_.size(); ++from) {
+            for (uint32_t i = distance_offsets_[from]; i < distance_offsets_[from + 1]; ++i) {
+                distances.push_back({ from, distance_targets_[i], distance_values_[i] });
+            }
+        }
+        return distances;
+    }
+
+    uint64_t TransportCatalogue::GetVersion() const {
+        return version_;
     }
 
-    const std::unordered_map<std::string, domain::Bus>& TransportCatalogue::GetBuses() const {
+    const std::deque<domain::Bus>& TransportCatalogue::GetBuses() const {
         return buses_;
     }
 
-    const std::unordered_map<std::string, domain::Stop>& TransportCatalogue::GetStops() const {
-        return filtered_stops_;
+    const std::deque<domain::Stop>& TransportCatalogue::GetStops() const {
+        return stops_;
     }
 
-    void TransportCatalogue::UpdateFilteredStops(const std::unordered_set<std::string>& stops_in_routes) {
-        filtered_stops_.clear();
-        for (const auto& stop_name : stops_in_routes) {
-            filtered_stops_.emplace(stop_name, stops_.at(stop_name));
+    MemoryUsage TransportCatalogue::GetMemoryUsage() const {
+        MemoryUsage usage;
+        usage.stops = stops_.size() * sizeof(domain::Stop);
+        usage.buses = buses_.size() * sizeof(domain::Bus);
+        for (const auto& bus : buses_) {
+            usage.buses += bus.stops.capacity() * sizeof(domain::StopId);
         }
+        usage.names = names_.GetAllocatedBytes();
+        usage.name_index = EstimateHashMapBytes(stop_ids_) + EstimateHashMapBytes(bus_ids_);
+        usage.stop_buses = stop_bus_offsets_.capacity() * sizeof(uint32_t)
+                           + stop_bus_ids_.capacity() * sizeof(domain::BusId);
+        usage.distances = distances_.capacity() * sizeof(domain::RoadDistance)
+                          + distance_offsets_.capacity() * sizeof(uint32_t)
+                          + distance_targets_.capacity() * sizeof(domain::StopId)
+                          + distance_values_.capacity() * sizeof(int)
+                          + distance_derived_.capacity() / 8;
+        usage.bus_infos = bus_infos_.capacity() * sizeof(domain::BusInfo);
+        usage.stop_index = stop_index_.GetMemoryUsage();
+        return usage;
+    }
+
+    size_t MemoryUsage::Total() const {
+        return stops + buses + names + name_index + stop_buses + distances + bus_infos + stop_index;
     }
 
 }  // namespace transport_catalogue
@@ -1,56 +1,156 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <deque>
 #include <unordered_map>
 #include <vector>
-#include <unordered_set>
 #include <string_view>
 #include <optional>
+#include "array_view.h"
 #include "domain.h"
+#include "geo_index.h"
+#include "name_pool.h"
 
 namespace transport_catalogue {
 
+    // Оценка памяти каталога в байтах по ёмкости контейнеров, без служебных данных аллокатора
+    struct MemoryUsage {
+        size_t stops = 0;
+        // Записи маршрутов вместе с последовательностями остановок
+        size_t buses = 0;
+        size_t names = 0;
+        // Хеш-таблицы поиска по имени
+        size_t name_index = 0;
+        size_t stop_buses = 0;
+        // Исходные расстояния и построенная из них матрица
+        size_t distances = 0;
+        size_t bus_infos = 0;
+        size_t stop_index = 0;
+
+        size_t Total() const;
+    };
+
     class TransportCatalogue {
     public:
         void AddStop(const domain::Stop& stop);
 
-        void AddBus(const domain::Bus& bus);
+        void AddBus(const std::string_view& name, const std::vector<std::string_view>& stops, bool is_circular);
+
+        // Маршрут из уже добавленных остановок, заданных идентификаторами
+        void AddBus(const std::string_view& name, std::vector<domain::StopId> stops, bool is_circular);
 
         void SetDistance(const std::string_view& from, const std::string_view& to, int distance);
 
+        void SetDistance(domain::StopId from, domain::StopId to, int distance);
+
+        // Завершает загрузку: строит индексы, нужные для запросов.
+        // Вызывается после добавления всех остановок, маршрутов и расстояний.
+        // Статистика маршрутов считается в thread_count потоках (0 — по числу ядер)
+        void Finalize(size_t thread_count = 1);
+
         const domain::Stop* FindStop(const std::string_view& name) const;
 
         const domain::Bus* FindBus(const std::string_view& name) const;
 
-        const std::vector<std::string_view>& GetBusStops(const std::string_view& bus_name) const;
+        std::optional<domain::StopId> FindStopId(const std::string_view& name) const;
 
-        domain::BusInfo GetBusInfo(const std::string_view& bus_name) const;
+        std::optional<domain::BusId> FindBusId(const std::string_view& name) const;
 
-        std::optional<std::vector<std::string>> GetBusesByStop(const std::string_view& stop_name) const;
+        const domain::Stop& GetStop(domain::StopId id) const;
 
-        int GetDistance(const std::string_view& from, const std::string_view& to) const;
+        const domain::Bus& GetBus(domain::BusId id) const;
 
-        const std::unordered_map<std::string, domain::Bus>& GetBuses() const;
-        const std::unordered_map<std::string, domain::Stop>& GetStops() const;
-        void UpdateFilteredStops(const std::unordered_set<std::string>& stops_in_routes);
+        const std::vector<domain::StopId>& GetBusStops(const std::string_view& bus_name) const;
 
+        // Статистика маршрута, посчитанная в Finalize
+        const domain::BusInfo& GetBusInfo(const std::string_view& bus_name) const;
 
-    private:
-        struct PairHash {
-            size_t operator()(const std::pair<const domain::Stop*, const domain::Stop*>& pair) const;
-        };
-        // Контейнеры для хранения информации об остановках и маршрутах
-        std::unordered_map<std::string, domain::Stop> stops_;
-        std::unordered_map<std::string, domain::Bus> buses_;
+        const domain::BusInfo& GetBusInfo(domain::BusId id) const;
+
+        // Идентификаторы маршрутов через остановку по возрастанию имени; nullopt, если остановки нет.
+        // Списки сортируются один раз в Finalize, запрос ничего не выделяет
+        std::optional<array_view::ArrayView<domain::BusId>> GetBusesByStop(const std::string_view& stop_name) const;
+
+        array_view::ArrayView<domain::BusId> GetBusIdsByStop(domain::StopId id) const;
+
+        // Остановки внутри прямоугольника по возрастанию id; использует сетку, построенную в Finalize
+        std::vector<domain::StopId> FindStopsInBox(const geo::BoundingBox& box) const;
 
+        // Остановки не дальше radius метров от center, от ближней к дальней; индекс точки — id остановки
+        std::vector<geo::GridIndex::Neighbor> FindStopsWithinRadius(geo::Coordinates center, double radius) const;
 
-        std::unordered_map<std::string_view, std::unordered_set<std::string>> buses_by_stop_;
+        std::optional<geo::GridIndex::Neighbor> FindNearestStop(geo::Coordinates center) const;
 
-        // Хранение расстояниz
-        std::unordered_map<std::pair<const domain::Stop*, const domain::Stop*>, int, PairHash> distances_;
+        // Наибольшие разности широт и долгот соседних остановок маршрутов, считаются в Finalize.
+        // Концы отрезка маршрута, задевающего прямоугольник, лежат в этом прямоугольнике,
+        // расширенном на эти величины
+        geo::Coordinates GetMaxSegmentSpan() const;
 
-        std::vector<std::string_view> stop_string_views_;
-        std::unordered_map<std::string, domain::Stop> filtered_stops_;
+        // Проходит ли через остановку хотя бы один маршрут
+        bool HasBuses(domain::StopId id) const;
+
+        int GetDistance(const std::string_view& from, const std::string_view& to) const;
+
+        int GetDistance(domain::StopId from, domain::StopId to) const;
+
+        // Все расстояния после Finalize, включая достроенные обратные направления, по возрастанию (from, to)
+        std::vector<domain::RoadDistance> GetDistances() const;
+
+        // Номер версии данных: растёт при каждом добавлении остановки, маршрута или расстояния.
+        // По нему производные кэши (например, отрисованная карта) понимают, что устарели
+        uint64_t GetVersion() const;
+
+        // Остановки и маршруты в порядке выдачи идентификаторов
+        const std::deque<domain::Stop>& GetStops() const;
+        const std::deque<domain::Bus>& GetBuses() const;
+
+        MemoryUsage GetMemoryUsage() const;
+
+    private:
+        void BuildDistanceIndex();
+        void BuildStopIndex();
+        void BuildStopBusIndex();
+        void ComputeMaxSegmentSpan();
+        void BuildBusInfos(size_t thread_count);
+        domain::BusInfo ComputeBusInfo(const domain::Bus& bus) const;
+        void CheckFinalized() const;
+
+        // Имена остановок и маршрутов; на них смотрят и записи, и ключи хеш-таблиц
+        name_pool::NamePool names_;
+
+        // Контейнеры для хранения информации об остановках и маршрутах.
+        // deque растёт без перекладывания уже добавленных записей
+        std::deque<domain::Stop> stops_;
+        std::deque<domain::Bus> buses_;
+        std::unordered_map<std::string_view, domain::StopId> stop_ids_;
+        std::unordered_map<std::string_view, domain::BusId> bus_ids_;
+
+        // Маршруты остановки id — stop_bus_ids_[stop_bus_offsets_[id] .. stop_bus_offsets_[id + 1])
+        // по возрастанию имени
+        std::vector<uint32_t> stop_bus_offsets_;
+        std::vector<domain::BusId> stop_bus_ids_;
+
+        // Расстояния, заданные после последнего Finalize, в порядке поступления; Finalize переносит их в CSR
+        std::vector<domain::RoadDistance> distances_;
+
+        // Сжатая строчная матрица (CSR): для остановки from соседи лежат в
+        // distance_targets_[distance_offsets_[from] .. distance_offsets_[from + 1]) по возрастанию id
+        std::vector<uint32_t> distance_offsets_;
+        std::vector<domain::StopId> distance_targets_;
+        std::vector<int> distance_values_;
+        // true для обратных направлений, достроенных из прямых: при повторном Finalize они не считаются явными
+        std::vector<bool> distance_derived_;
+
+        // Индексируется идентификатором маршрута
+        std::vector<domain::BusInfo> bus_infos_;
+
+        // Пространственный индекс остановок; индекс точки совпадает с идентификатором остановки
+        geo::GridIndex stop_index_;
+        geo::Coordinates max_segment_span_ = { 0, 0 };
+
+        uint64_t version_ = 0;
+        bool finalized_ = false;
     };
 
 }  // namespace transport_catalogue
@@ -0,0 +1,98 @@
+#include "transport_router.h"
+
+namespace transport_router {
+
+    namespace {
+
+        // км/ч -> м/мин
+        constexpr double KMH_TO_METERS_PER_MINUTE = 1000.0 / 60.0;
+
+    }  // namespace
+
+    TransportRouter::TransportRouter(const transport_catalogue::TransportCatalogue& tc, RoutingSettings settings)
+            : tc_(tc)
+            , settings_(settings)
+            , graph_(tc.GetStops().size() * 2) {
+        BuildGraph();
+        router_.emplace(graph_);
+    }
+
+    graph::VertexId TransportRouter::GetArrivalVertex(domain::StopId id) {
+        return id * 2;
+    }
+
+    graph::VertexId TransportRouter::GetBoardingVertex(domain::StopId id) {
+        return id * 2 + 1;
+    }
+
+    void TransportRouter::AddEdge(graph::VertexId from, graph::VertexId to, double time, EdgeInfo info) {
+        graph_.AddEdge({ from, to, time });
+        edge_infos_.push_back(info);
+    }
+
+    void TransportRouter::BuildGraph() {
+        const auto& stops = tc_.GetStops();
+        for (domain::StopId id = 0; id < stops.size(); ++id) {
+            AddEdge(GetArrivalVertex(id), GetBoardingVertex(id), settings_.bus_wait_time,
+                    { RouteItemType::WAIT, stops[id].name, 0 });
+        }
+
+        for (const auto& bus : tc_.GetBuses()) {
+            AddBusEdges(bus, bus.stops);
+            if (!bus.is_circular) {
+                AddBusEdges(bus, { bus.stops.rbegin(), bus.stops.rend() });
+            }
+        }
+
+        graph_.BuildIncidence();
+    }
+
+    void TransportRouter::AddBusEdges(const domain::Bus& bus, const std::vector<domain::StopId>& stops) {
+        const double meters_per_minute = settings_.bus_velocity * KMH_TO_METERS_PER_MINUTE;
+        for (size_t from = 0; from + 1 < stops.size(); ++from) {
+            // Расстояние копится вдоль маршрута, поэтому все рёбра из остановки строятся за один проход
+            double distance = 0;
+            for (size_t to = from + 1; to < stops.size(); ++to) {
+                distance += tc_.GetDistance(stops[to - 1], stops[to]);
+                AddEdge(GetBoardingVertex(stops[from]), GetArrivalVertex(stops[to]), distance / meters_per_minute,
+                        { RouteItemType::BUS, bus.name, static_cast<int>(to - from) });
+            }
+        }
+    }
+
+    std::optional<RouteResult> TransportRouter::BuildRoute(std::string_view from, std::string_view to) const {
+        const auto from_id = tc_.FindStopId(from);
+        const auto to_id = tc_.FindStopId(to);
+        if (!from_id || !to_id) {
+            return std::nullopt;
+        }
+
+        const auto route = router_->BuildRoute(GetArrivalVertex(*from_id), GetArrivalVertex(*to_id));
+        if (!route) {
+            return std::nullopt;
+        }
+
+        RouteResult result;
+        result.total_time = route->weight;
+        result.items.reserve(route->edges.size());
+        for (const graph::EdgeId edge_id : route->edges) {
+            const auto& info = edge_infos_[edge_id];
+            result.items.push_back({ info.type, info.name, info.span_count, graph_.GetEdge(edge_id).weight });
+        }
+        return result;
+    }
+
+    void TransportRouter::Precompute(size_t thread_count) const {
+        std::vector<graph::VertexId> sources;
+        sources.reserve(tc_.GetStops().size());
+        for (domain::StopId id = 0; id < tc_.GetStops().size(); ++id) {
+            sources.push_back(GetArrivalVertex(id));
+        }
+        router_->Precompute(sources, thread_count);
+    }
+
+    size_t TransportRouter::GetCachedRoutesBytes() const {
+        return router_->GetCachedRoutesBytes();
+    }
+
+}  // namespace transport_router
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "transport_catalogue.h"
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace transport_router {
+
+    struct RoutingSettings {
+        // Время ожидания автобуса на остановке, минуты
+        int bus_wait_time = 0;
+        // Скорость автобуса, км/ч
+        double bus_velocity = 0;
+    };
+
+    enum class RouteItemType {
+        WAIT,
+        BUS,
+    };
+
+    struct RouteItem {
+        RouteItemType type;
+        // Название остановки для WAIT, название маршрута для BUS
+        std::string_view name;
+        // Число перегонов, проезжаемых на автобусе (только для BUS)
+        int span_count = 0;
+        // Минуты
+        double time = 0;
+    };
+
+    struct RouteResult {
+        double total_time = 0;
+        std::vector<RouteItem> items;
+    };
+
+    // Маршрутизатор поверх каталога. У каждой остановки две вершины: «пришёл на остановку»
+    // и «дождался автобуса», между ними ребро ожидания. Для каждого маршрута из каждой остановки
+    // ведут рёбра поездки до всех следующих по ходу остановок. Каталог должен быть финализирован
+    // и не меняться, пока жив маршрутизатор
+    class TransportRouter {
+    public:
+        TransportRouter(const transport_catalogue::TransportCatalogue& tc, RoutingSettings settings);
+
+        // router_ ссылается на graph_ этого же объекта, поэтому ни копировать, ни перемещать нельзя
+        TransportRouter(const TransportRouter&) = delete;
+        TransportRouter& operator=(const TransportRouter&) = delete;
+        TransportRouter(TransportRouter&&) = delete;
+        TransportRouter& operator=(TransportRouter&&) = delete;
+
+        std::optional<RouteResult> BuildRoute(std::string_view from, std::string_view to) const;
+
+        // Заранее считает маршруты из всех остановок в thread_count потоках (0 — по числу ядер).
+        // Без этого маршруты из остановки считаются при первом запросе из неё.
+        // Память под них квадратична по числу остановок, см. GetCachedRoutesBytes
+        void Precompute(size_t thread_count) const;
+
+        // Память под посчитанные маршруты из остановок
+        size_t GetCachedRoutesBytes() const;
+
+    private:
+        using Graph = graph::DirectedWeightedGraph<double>;
+
+        struct EdgeInfo {
+            RouteItemType type;
+            std::string_view name;
+            int span_count;
+        };
+
+        void BuildGraph();
+        void AddBusEdges(const domain::Bus& bus, const std::vector<domain::StopId>& stops);
+        void AddEdge(graph::VertexId from, graph::VertexId to, double time, EdgeInfo info);
+
+        static graph::VertexId GetArrivalVertex(domain::StopId id);
+        static graph::VertexId GetBoardingVertex(domain::StopId id);
+
+        const transport_catalogue::TransportCatalogue& tc_;
+        RoutingSettings settings_;
+        Graph graph_;
+        // Индексируется идентификатором ребра
+        std::vector<EdgeInfo> edge_infos_;
+        std::optional<graph::Router<double>> router_;
+    };
+
+}  // namespace transport_router